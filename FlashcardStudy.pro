@@ -3,27 +3,67 @@ TARGET = MainWindow
 
 QT = core gui
 
+CONFIG += c++17
+
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 SOURCES += \
+        binarydeckstore.cpp \
+        cardarena.cpp \
+        csvdeckreader.cpp \
+        deckbundle.cpp \
         deck.cpp \
+        deckindex.cpp \
+        deckjournal.cpp \
+        deckpatch.cpp \
         deckwindow.cpp \
+        duplicatefinder.cpp \
         flashcard.cpp \
         flashcardmanager.cpp \
+        instrumentation.cpp \
+        jsonstreamreader.cpp \
+        jsonstreamwriter.cpp \
         main.cpp \
         mainwindow.cpp \
+        persistenceworker.cpp \
+        reviewlog.cpp \
+        reviewscheduler.cpp \
+        reviewstats.cpp \
+        searchindex.cpp \
         statstracker.cpp \
-        studywindow.cpp
+        statswindow.cpp \
+        stringpool.cpp \
+        studywindow.cpp \
+        tagquery.cpp
 
 HEADERS += \
+    binarydeckstore.h \
+    cardarena.h \
+    csvdeckreader.h \
+    deckbundle.h \
     deck.h \
+    deckindex.h \
+    deckjournal.h \
+    deckpatch.h \
     deckwindow.h \
+    duplicatefinder.h \
     flashcard.h \
     flashcardfactory.h \
     flashcardmanager.h \
+    instrumentation.h \
+    jsonstreamreader.h \
+    jsonstreamwriter.h \
     mainwindow.h \
+    persistenceworker.h \
+    reviewlog.h \
+    reviewscheduler.h \
+    reviewstats.h \
+    searchindex.h \
     statstracker.h \
-    studywindow.h
+    statswindow.h \
+    stringpool.h \
+    studywindow.h \
+    tagquery.h
 
 FORMS += \
     deckwindow.ui \
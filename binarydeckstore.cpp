@@ -0,0 +1,273 @@
+#include "binarydeckstore.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <cstring>
+
+static const char Magic[4] = { 'F', 'C', 'D', 'B' };
+static const quint32 EndianMarker = 0x01020304;
+static const qint64 FileHeaderSize = 16;
+static const qint64 DeckHeaderSize = 16;
+static const qint64 CardEntrySize = 24;      // version 2: id + text offsets
+static const qint64 CardEntrySizeV1 = 16;    // version 1: text offsets only
+
+static quint32 readU32(const uchar *p)
+{
+    quint32 v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static quint64 readU64(const uchar *p)
+{
+    quint64 v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void putU32(uchar *p, quint32 v)
+{
+    std::memcpy(p, &v, sizeof(v));
+}
+
+static void putU64(uchar *p, quint64 v)
+{
+    std::memcpy(p, &v, sizeof(v));
+}
+
+static qint64 paddedRecordSize(qint64 entrySize, qint64 cardCount, qint64 textUnits)
+{
+    const qint64 size = DeckHeaderSize + entrySize * cardCount + 2 * textUnits;
+    return (size + 7) & ~qint64(7);
+}
+
+// ---------------------------------------------------------
+// BinaryDeckView
+// ---------------------------------------------------------
+
+QStringView BinaryDeckView::text(quint32 offset, quint32 length) const
+{
+    if (!m_text || quint64(offset) + length > m_textUnits) return QStringView();
+    return QStringView(m_text + offset, qsizetype(length));
+}
+
+QStringView BinaryDeckView::name() const
+{
+    if (!m_record) return QStringView();
+    return text(0, readU32(m_record));
+}
+
+QStringView BinaryDeckView::tag() const
+{
+    if (!m_record) return QStringView();
+    return text(readU32(m_record), readU32(m_record + 4));
+}
+
+int BinaryDeckView::cardCount() const
+{
+    return m_record ? int(readU32(m_record + 8)) : 0;
+}
+
+// Text offsets of a card entry; a version 2 entry starts with the id
+const uchar *BinaryDeckView::entry(int index) const
+{
+    if (index < 0 || index >= cardCount()) return nullptr;
+    const uchar *e = m_record + DeckHeaderSize + m_entrySize * index;
+    return m_hasIds ? e + 8 : e;
+}
+
+quint64 BinaryDeckView::id(int index) const
+{
+    if (!m_hasIds || index < 0 || index >= cardCount()) return 0;
+    return readU64(m_record + DeckHeaderSize + m_entrySize * index);
+}
+
+QStringView BinaryDeckView::question(int index) const
+{
+    const uchar *e = entry(index);
+    return e ? text(readU32(e), readU32(e + 4)) : QStringView();
+}
+
+QStringView BinaryDeckView::answer(int index) const
+{
+    const uchar *e = entry(index);
+    return e ? text(readU32(e + 8), readU32(e + 12)) : QStringView();
+}
+
+deck BinaryDeckView::toDeck() const
+{
+    deck d(name().toString(), tag().toString());
+    const int n = cardCount();
+    d.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        const quint64 cardId = id(i);
+        if (m_hasIds && cardId == 0) continue;   // empty slot
+        d.addCard(flashcard(question(i).toString(), answer(i).toString(), cardId));
+    }
+    return d;
+}
+
+// ---------------------------------------------------------
+// BinaryDeckStore
+// ---------------------------------------------------------
+
+BinaryDeckStore::~BinaryDeckStore()
+{
+    close();
+}
+
+bool BinaryDeckStore::write(const QString &path, const QVector<deck> &decks, QString *errorOut)
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for writing.").arg(path);
+        return false;
+    }
+
+    // First pass: record sizes, so the offset table can be written up front
+    QVector<qint64> textUnits(decks.size());
+    QVector<quint64> offsets(decks.size());
+    qint64 pos = FileHeaderSize + 8 * qint64(decks.size());
+    for (int i = 0; i < decks.size(); ++i) {
+        const deck &d = decks[i];
+        qint64 units = d.getName().size() + d.getTag().size();
+        for (const flashcard &fc : d) {
+            units += fc.getQuestion().size() + fc.getAnswer().size();
+        }
+        if (units > qint64(0xffffffffu)) {
+            if (errorOut) *errorOut = QString("Deck %1 is too large for the binary format.").arg(d.getName());
+            return false;
+        }
+        textUnits[i] = units;
+        offsets[i] = quint64(pos);
+        pos += paddedRecordSize(CardEntrySize, d.getSize(), units);
+    }
+
+    uchar header[FileHeaderSize];
+    std::memcpy(header, Magic, 4);
+    putU32(header + 4, Version);
+    putU32(header + 8, quint32(decks.size()));
+    putU32(header + 12, EndianMarker);
+    f.write(reinterpret_cast<const char *>(header), FileHeaderSize);
+    f.write(reinterpret_cast<const char *>(offsets.constData()), 8 * qint64(offsets.size()));
+
+    // Second pass: one buffer per deck record
+    for (int i = 0; i < decks.size(); ++i) {
+        const deck &d = decks[i];
+        const int n = d.getSize();
+        QByteArray record(int(paddedRecordSize(CardEntrySize, n, textUnits[i])), '\0');
+        uchar *base = reinterpret_cast<uchar *>(record.data());
+        QChar *text = reinterpret_cast<QChar *>(base + DeckHeaderSize + CardEntrySize * n);
+        quint32 cursor = 0;
+
+        auto putText = [&](const QString &s) {
+            std::memcpy(text + cursor, s.constData(), size_t(s.size()) * sizeof(QChar));
+            const quint32 at = cursor;
+            cursor += quint32(s.size());
+            return at;
+        };
+
+        putU32(base, quint32(d.getName().size()));
+        putU32(base + 4, quint32(d.getTag().size()));
+        putU32(base + 8, quint32(n));
+        putU32(base + 12, quint32(textUnits[i]));
+        putText(d.getName());
+        putText(d.getTag());
+
+        int c = 0;
+        for (const flashcard &fc : d) {
+            uchar *e = base + DeckHeaderSize + CardEntrySize * c++;
+            putU64(e, fc.getId());
+            e += 8;
+            putU32(e + 4, quint32(fc.getQuestion().size()));
+            putU32(e, putText(fc.getQuestion()));
+            putU32(e + 12, quint32(fc.getAnswer().size()));
+            putU32(e + 8, putText(fc.getAnswer()));
+        }
+        f.write(record);
+    }
+
+    if (!f.commit()) {
+        if (errorOut) *errorOut = QString("Could not write %1.").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool BinaryDeckStore::open(const QString &path, QString *errorOut)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for reading.").arg(path);
+        return false;
+    }
+
+    m_size = m_file.size();
+    m_data = m_size > 0 ? m_file.map(0, m_size) : nullptr;
+    if (!m_data) {
+        m_fallback = m_file.readAll();
+        m_data = reinterpret_cast<const uchar *>(m_fallback.constData());
+    }
+
+    m_version = m_size >= FileHeaderSize ? readU32(m_data + 4) : 0;
+    if (m_size < FileHeaderSize || std::memcmp(m_data, Magic, 4) != 0
+        || m_version < 1 || m_version > Version || readU32(m_data + 12) != EndianMarker) {
+        if (errorOut) *errorOut = QString("%1 is not a supported deck store.").arg(path);
+        close();
+        return false;
+    }
+
+    m_deckCount = int(readU32(m_data + 8));
+    if (FileHeaderSize + 8 * qint64(m_deckCount) > m_size) {
+        if (errorOut) *errorOut = QString("%1 is truncated.").arg(path);
+        close();
+        return false;
+    }
+    return true;
+}
+
+void BinaryDeckStore::close()
+{
+    if (m_data && m_fallback.isEmpty()) m_file.unmap(const_cast<uchar *>(m_data));
+    m_file.close();
+    m_fallback.clear();
+    m_data = nullptr;
+    m_size = 0;
+    m_deckCount = 0;
+    m_version = 0;
+}
+
+// Validates the record's bounds once so card access can stay branch-light
+BinaryDeckView BinaryDeckStore::deckAt(int index) const
+{
+    BinaryDeckView view;
+    if (!m_data || index < 0 || index >= m_deckCount) return view;
+
+    const quint64 offset = readU64(m_data + FileHeaderSize + 8 * qint64(index));
+    if (offset % 8 != 0 || offset + DeckHeaderSize > quint64(m_size)) return view;
+
+    const uchar *record = m_data + offset;
+    const quint32 cards = readU32(record + 8);
+    const quint32 units = readU32(record + 12);
+    const qint64 entrySize = m_version >= 2 ? CardEntrySize : CardEntrySizeV1;
+    if (offset + quint64(paddedRecordSize(entrySize, cards, units)) > quint64(m_size)) return view;
+
+    view.m_record = record;
+    view.m_entrySize = entrySize;
+    view.m_hasIds = m_version >= 2;
+    view.m_text = reinterpret_cast<const QChar *>(record + DeckHeaderSize + entrySize * qint64(cards));
+    view.m_textUnits = units;
+    return view;
+}
+
+int BinaryDeckStore::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_deckCount; ++i) {
+        if (deckAt(i).name() == name) return i;
+    }
+    return -1;
+}
@@ -0,0 +1,101 @@
+#ifndef BINARYDECKSTORE_H
+#define BINARYDECKSTORE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+#include "deck.h"
+
+/*
+ * BinaryDeckStore (optional .fcdb storage, version 2)
+ *
+ * Layout (native byte order, checked through an endian marker):
+ *   header      "FCDB", quint32 version, quint32 deckCount, quint32 endianMarker
+ *   offsets     quint64 per deck, absolute file offset of its record
+ *   deck record quint32 nameLen, tagLen, cardCount, textUnits
+ *               cardCount x { quint64 id, quint32 qOff, qLen, aOff, aLen }  (UTF-16 units into text)
+ *               text: name, tag, then every question/answer as UTF-16, padded to 8 bytes
+ *
+ * Card ids are kept, so a library converted to binary and back still merges and
+ * diffs against earlier exports by id. Removed cards are never written (the
+ * JSON export doesn't carry them either); an id of 0 in a record marks an empty
+ * slot and is skipped. Version 1 files (no ids) still open; their cards get
+ * fresh ids when materialized.
+ *
+ * The file is mmap'ed and strings are handed out as QStringViews straight into the
+ * mapping, so reading a card allocates nothing. Views are valid until close().
+ * JSON stays the interchange format; see flashcardManager::convertJsonToBinary().
+ */
+
+class BinaryDeckView
+{
+public:
+    BinaryDeckView() = default;
+
+    bool isValid() const { return m_record != nullptr; }
+    QStringView name() const;
+    QStringView tag() const;
+    int cardCount() const;
+    quint64 id(int index) const;   // 0 in version 1 files
+    QStringView question(int index) const;
+    QStringView answer(int index) const;
+
+    deck toDeck() const;   // copies into a regular deck
+
+private:
+    friend class BinaryDeckStore;
+    QStringView text(quint32 offset, quint32 length) const;
+    const uchar *entry(int index) const;
+
+    const uchar *m_record = nullptr;
+    qint64 m_entrySize = 0;
+    bool m_hasIds = false;
+    const QChar *m_text = nullptr;
+    quint32 m_textUnits = 0;
+};
+
+struct StoreLoadComparison
+{
+    int decks = 0;
+    qint64 cards = 0;
+    qint64 jsonBytes = 0;
+    qint64 binaryBytes = 0;
+    qint64 jsonLoadMs = 0;          // readAll + fromJson + build decks
+    qint64 binaryOpenMs = 0;        // map + validate
+    qint64 binaryScanMs = 0;        // touch every question/answer through views
+    qint64 binaryMaterializeMs = 0; // toDeck() for every deck
+};
+
+class BinaryDeckStore
+{
+public:
+    static const quint32 Version = 2;
+
+    BinaryDeckStore() = default;
+    ~BinaryDeckStore();
+    BinaryDeckStore(const BinaryDeckStore&) = delete;
+    BinaryDeckStore& operator=(const BinaryDeckStore&) = delete;
+
+    static bool write(const QString &path, const QVector<deck> &decks, QString *errorOut = nullptr);
+
+    bool open(const QString &path, QString *errorOut = nullptr);
+    void close();
+    bool isOpen() const { return m_data != nullptr; }
+
+    int deckCount() const { return m_deckCount; }
+    BinaryDeckView deckAt(int index) const;
+    int indexOf(const QString &name) const;
+    qint64 sizeInBytes() const { return m_size; }
+
+private:
+    QFile m_file;
+    QByteArray m_fallback;   // used when the platform can't map the file
+    const uchar *m_data = nullptr;
+    qint64 m_size = 0;
+    int m_deckCount = 0;
+    quint32 m_version = 0;
+};
+
+#endif // BINARYDECKSTORE_H
@@ -0,0 +1,112 @@
+#include "cardarena.h"
+
+#include <algorithm>
+#include <functional>
+
+void CardArena::reserve(int slots, qint64 textUnits)
+{
+    m_ids.reserve(slots);
+    m_qOff.reserve(slots);
+    m_qLen.reserve(slots);
+    m_aOff.reserve(slots);
+    m_aLen.reserve(slots);
+    if (textUnits > 0) m_text.reserve(int(textUnits));
+}
+
+quint32 CardArena::store(QStringView s)
+{
+    // Text that already lives in the arena would move under us when it grows
+    const std::less<const QChar *> before;
+    if (!s.isEmpty() && !before(s.data(), m_text.constData()) && before(s.data(), m_text.constData() + m_text.size())) {
+        const QString copy = s.toString();
+        return store(QStringView(copy));
+    }
+
+    const quint32 at = quint32(m_text.size());
+    m_text.resize(m_text.size() + int(s.size()));
+    std::copy(s.begin(), s.end(), m_text.begin() + at);
+    return at;
+}
+
+void CardArena::append(quint64 id, QStringView question, QStringView answer)
+{
+    m_ids.append(id);
+    m_qLen.append(quint32(question.size()));
+    m_qOff.append(store(question));
+    m_aLen.append(quint32(answer.size()));
+    m_aOff.append(store(answer));
+}
+
+void CardArena::set(int slot, QStringView question, QStringView answer)
+{
+    m_garbage += m_qLen.at(slot) + m_aLen.at(slot);
+    m_qLen[slot] = quint32(question.size());
+    m_qOff[slot] = store(question);
+    m_aLen[slot] = quint32(answer.size());
+    m_aOff[slot] = store(answer);
+    if (m_garbage * 2 > m_text.size()) compactText();
+}
+
+void CardArena::clear(int slot)
+{
+    m_garbage += m_qLen.at(slot) + m_aLen.at(slot);
+    m_ids[slot] = 0;
+    m_qOff[slot] = 0;
+    m_qLen[slot] = 0;
+    m_aOff[slot] = 0;
+    m_aLen[slot] = 0;
+    if (m_garbage * 2 > m_text.size()) compactText();
+}
+
+// Copies live text into a fresh buffer in slot order
+void CardArena::compactText()
+{
+    QVector<QChar> text;
+    text.reserve(int(m_text.size() - m_garbage));
+    auto move = [&](quint32 &off, quint32 len) {
+        const quint32 at = quint32(text.size());
+        text.resize(text.size() + int(len));
+        std::copy(m_text.constBegin() + off, m_text.constBegin() + off + len, text.begin() + at);
+        off = at;
+    };
+    for (int i = 0; i < m_ids.size(); ++i) {
+        if (m_ids[i] == 0) continue;
+        move(m_qOff[i], m_qLen[i]);
+        move(m_aOff[i], m_aLen[i]);
+    }
+    m_text = text;
+    m_garbage = 0;
+}
+
+void CardArena::removeTombstones()
+{
+    int out = 0;
+    for (int in = 0; in < m_ids.size(); ++in) {
+        if (m_ids[in] == 0) continue;
+        if (in != out) {
+            m_ids[out] = m_ids[in];
+            m_qOff[out] = m_qOff[in];
+            m_qLen[out] = m_qLen[in];
+            m_aOff[out] = m_aOff[in];
+            m_aLen[out] = m_aLen[in];
+        }
+        ++out;
+    }
+    m_ids.resize(out);
+    m_qOff.resize(out);
+    m_qLen.resize(out);
+    m_aOff.resize(out);
+    m_aLen.resize(out);
+}
+
+void CardArena::clearAll()
+{
+    *this = CardArena();
+}
+
+qint64 CardArena::memoryBytes() const
+{
+    return qint64(m_text.capacity()) * qint64(sizeof(QChar))
+        + qint64(m_ids.capacity()) * qint64(sizeof(quint64))
+        + qint64(m_qOff.capacity() + m_qLen.capacity() + m_aOff.capacity() + m_aLen.capacity()) * qint64(sizeof(quint32));
+}
@@ -0,0 +1,56 @@
+#ifndef CARDARENA_H
+#define CARDARENA_H
+
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+/*
+ * CardArena (structure-of-arrays card storage for very large decks)
+ *
+ *  - All question/answer text lives in one contiguous UTF-16 buffer; each card is
+ *    an id plus offset/length pairs in parallel arrays. A million cards cost a
+ *    handful of allocations instead of two per card.
+ *  - Slots are addressed like deck's card vector: removal leaves a tombstone
+ *    (id 0) and editing a card appends its new text. The text left behind is
+ *    reclaimed once it makes up half the buffer.
+ *  - Offsets are quint32, so one arena holds at most 4G UTF-16 units.
+ */
+
+class CardArena
+{
+public:
+    int slotCount() const { return m_ids.size(); }
+    quint64 id(int slot) const { return m_ids.at(slot); }
+    QStringView question(int slot) const { return text(m_qOff.at(slot), m_qLen.at(slot)); }
+    QStringView answer(int slot) const { return text(m_aOff.at(slot), m_aLen.at(slot)); }
+
+    void reserve(int slots, qint64 textUnits = 0);
+    void append(quint64 id, QStringView question, QStringView answer);
+    void set(int slot, QStringView question, QStringView answer);
+    void clear(int slot);   // leaves a tombstone
+    void removeTombstones();
+    void clearAll();
+
+    qint64 textUnits() const { return m_text.size(); }
+    qint64 garbageUnits() const { return m_garbage; }
+    qint64 memoryBytes() const;
+
+private:
+    QStringView text(quint32 offset, quint32 length) const
+    {
+        return QStringView(m_text.constData() + offset, qsizetype(length));
+    }
+    quint32 store(QStringView s);
+    void compactText();
+
+    QVector<QChar> m_text;
+    QVector<quint64> m_ids;
+    QVector<quint32> m_qOff;
+    QVector<quint32> m_qLen;
+    QVector<quint32> m_aOff;
+    QVector<quint32> m_aLen;
+    qint64 m_garbage = 0;   // units no live card points at
+};
+
+#endif // CARDARENA_H
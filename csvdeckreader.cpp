@@ -0,0 +1,212 @@
+#include "csvdeckreader.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QtAlgorithms>
+#include <QVector>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+static const qint64 ProgressStep = 1 << 20;
+
+// First byte at or after p that is the delimiter, '\n' or '\r' (end if none)
+static const char *findFieldEnd(const char *p, const char *end, char delim)
+{
+#ifdef __SSE2__
+    const __m128i d = _mm_set1_epi8(delim);
+    const __m128i lf = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, d),
+                                         _mm_or_si128(_mm_cmpeq_epi8(v, lf), _mm_cmpeq_epi8(v, cr)));
+        const int mask = _mm_movemask_epi8(hit);
+        if (mask) return p + qCountTrailingZeroBits(uint(mask));
+        p += 16;
+    }
+#endif
+    while (p < end && *p != delim && *p != '\n' && *p != '\r') ++p;
+    return p;
+}
+
+// First '"' at or after p (end if none)
+static const char *findQuote(const char *p, const char *end)
+{
+#ifdef __SSE2__
+    const __m128i q = _mm_set1_epi8('"');
+    while (end - p >= 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+        const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(v, q));
+        if (mask) return p + qCountTrailingZeroBits(uint(mask));
+        p += 16;
+    }
+#endif
+    while (p < end && *p != '"') ++p;
+    return p;
+}
+
+namespace {
+struct Field
+{
+    const char *p = nullptr;
+    int len = 0;
+    bool escaped = false;   // quoted and contains "" pairs
+};
+}
+
+static bool fieldEquals(const Field &f, const char *word)
+{
+    return QByteArray::fromRawData(f.p, f.len).trimmed().toLower() == word;
+}
+
+bool CsvDeckReader::parse(const char *data, qint64 size, char delimiter, deck &out, QString *errorOut,
+                          CsvImportStats *stats, const Progress &progress)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const char *p = data;
+    const char *end = data + size;
+    if (size >= 3 && std::memcmp(p, "\xEF\xBB\xBF", 3) == 0) p += 3;
+
+    QVector<flashcard> cards;
+    QByteArray scratch;
+    QString tag = out.getTag();
+    qint64 skipped = 0;
+    qint64 nextReport = ProgressStep;
+    bool firstRow = true;
+
+    auto decode = [&](const Field &f) {
+        if (!f.escaped) return QString::fromUtf8(f.p, f.len);
+        scratch.resize(0);
+        for (int i = 0; i < f.len; ++i) {
+            scratch.append(f.p[i]);
+            if (f.p[i] == '"') ++i;   // second half of a "" pair
+        }
+        return QString::fromUtf8(scratch);
+    };
+
+    while (p < end) {
+        Field fields[3];
+        int count = 0;
+
+        for (;;) {
+            Field f;
+            if (p < end && *p == '"') {
+                const char *start = ++p;
+                for (;;) {
+                    const char *q = findQuote(p, end);
+                    if (q == end) {
+                        if (errorOut) *errorOut = QString("Unterminated quoted field (at byte %1).").arg(start - 1 - data);
+                        return false;
+                    }
+                    if (q + 1 < end && q[1] == '"') {
+                        f.escaped = true;
+                        p = q + 2;
+                        continue;
+                    }
+                    f.p = start;
+                    f.len = int(q - start);
+                    p = q + 1;
+                    break;
+                }
+                // Anything between the closing quote and the delimiter is dropped
+                p = findFieldEnd(p, end, delimiter);
+            } else {
+                const char *q = findFieldEnd(p, end, delimiter);
+                f.p = p;
+                f.len = int(q - p);
+                p = q;
+            }
+
+            if (count < 3) fields[count++] = f;   // extra columns are ignored
+            if (p < end && *p == delimiter) {
+                ++p;
+                continue;
+            }
+            break;
+        }
+        if (p < end && *p == '\r') ++p;
+        if (p < end && *p == '\n') ++p;
+
+        if (progress && p - data >= nextReport) {
+            nextReport += ProgressStep;
+            if (!progress(p - data, size)) {
+                if (errorOut) *errorOut = "Import cancelled.";
+                return false;
+            }
+        }
+
+        if (count == 1 && fields[0].len == 0) continue;   // blank line
+
+        if (firstRow) {
+            firstRow = false;
+            if (count >= 2 && fieldEquals(fields[0], "question") && fieldEquals(fields[1], "answer")) continue;
+        }
+
+        if (count < 2 || fields[0].len == 0 || fields[1].len == 0) {
+            ++skipped;
+            continue;
+        }
+
+        cards.append(flashcard(decode(fields[0]), decode(fields[1])));
+        if (count == 3 && tag.isEmpty() && fields[2].len > 0) tag = decode(fields[2]).trimmed();
+    }
+
+    const qint64 rows = cards.size();
+    out.addCards(std::move(cards));
+    if (tag != out.getTag()) out.setTag(tag);
+
+    if (stats) {
+        stats->bytes = size;
+        stats->rows = rows;
+        stats->skippedRows = skipped;
+        stats->parseMs = timer.elapsed();
+    }
+    if (progress) progress(size, size);
+    return true;
+}
+
+bool CsvDeckReader::read(const QString &path, deck &out, QString *errorOut, CsvImportStats *stats,
+                         char delimiter, const Progress &progress)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = "Could not open file for reading.";
+        return false;
+    }
+
+    const qint64 size = f.size();
+    uchar *mapped = size > 0 ? f.map(0, size) : nullptr;
+    QByteArray fallback;
+    if (!mapped && size > 0) fallback = f.readAll();
+    const char *data = mapped ? reinterpret_cast<const char *>(mapped) : fallback.constData();
+
+    if (delimiter == 0) {
+        const QString suffix = QFileInfo(path).suffix().toLower();
+        if (suffix == "tsv" || suffix == "tab") {
+            delimiter = '\t';
+        } else {
+            const qint64 probe = qMin<qint64>(size, 64 * 1024);
+            const char *lineEnd = probe > 0 ? static_cast<const char *>(std::memchr(data, '\n', size_t(probe))) : nullptr;
+            const qint64 lineLen = lineEnd ? lineEnd - data : probe;
+            delimiter = (lineLen > 0 && std::memchr(data, '\t', size_t(lineLen))) ? '\t' : ',';
+        }
+    }
+
+    out = deck(QFileInfo(path).completeBaseName(), "");
+    const bool ok = parse(data, size, delimiter, out, errorOut, stats, progress);
+
+    if (mapped) f.unmap(mapped);
+    return ok;
+}
+
+bool CsvDeckReader::isCsvPath(const QString &path)
+{
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    return suffix == "csv" || suffix == "tsv" || suffix == "tab";
+}
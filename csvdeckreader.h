@@ -0,0 +1,51 @@
+#ifndef CSVDECKREADER_H
+#define CSVDECKREADER_H
+
+#include <QByteArray>
+#include <QString>
+#include <functional>
+#include "deck.h"
+
+/*
+ * CsvDeckReader (CSV/TSV card ingestion)
+ *
+ *  - One card per row: question, answer and an optional third tag column. The
+ *    first non-empty tag becomes the deck's tag. A "question,answer[,tag]" header
+ *    row is skipped.
+ *  - RFC 4180 quoting: quoted fields may hold delimiters, newlines and "" escapes.
+ *    Rows with an empty question or answer are skipped and counted.
+ *  - The file is memory-mapped and scanned for delimiters/newlines 16 bytes at a
+ *    time with SSE2 (scalar fallback elsewhere). Unescaped fields are decoded
+ *    straight from the mapping; only fields with "" escapes go through a scratch
+ *    buffer.
+ */
+
+struct CsvImportStats
+{
+    qint64 bytes = 0;
+    qint64 rows = 0;          // cards added
+    qint64 skippedRows = 0;   // blank or incomplete rows
+    qint64 parseMs = 0;
+
+    double rowsPerSecond() const { return parseMs > 0 ? rows * 1000.0 / parseMs : 0.0; }
+    double megabytesPerSecond() const { return parseMs > 0 ? bytes / 1048.576 / parseMs : 0.0; }
+};
+
+class CsvDeckReader
+{
+public:
+    using Progress = std::function<bool(qint64 bytesRead, qint64 totalBytes)>;
+
+    // delimiter 0 = auto: tab for .tsv/.tab files or a tab in the first line, else comma
+    static bool read(const QString &path, deck &out, QString *errorOut = nullptr,
+                     CsvImportStats *stats = nullptr, char delimiter = 0,
+                     const Progress &progress = Progress());
+
+    // Parses an in-memory buffer; read() maps the file and calls this
+    static bool parse(const char *data, qint64 size, char delimiter, deck &out, QString *errorOut = nullptr,
+                      CsvImportStats *stats = nullptr, const Progress &progress = Progress());
+
+    static bool isCsvPath(const QString &path);
+};
+
+#endif // CSVDECKREADER_H
@@ -1,20 +1,109 @@
 #include "deck.h"
+#include "flashcardfactory.h"
+
+#include <utility>
 
 deck::deck(const QString &name, const QString &tag) : name(name), tag(tag) {}
 
-// Adds a card
-void deck::addCard(const flashcard &card){
-    cards.append(card);
+int deck::slotCount() const {
+    return storageMode == Storage::Arena ? arena.slotCount() : cards.size();
+}
+
+quint64 deck::slotId(int slot) const {
+    return storageMode == Storage::Arena ? arena.id(slot) : cards.at(slot).getId();
+}
+
+// Vector storage hands out the stored card; arena storage copies its text into stash.
+// The copy owns its strings, so text taken from it outlives later edits of the arena.
+const flashcard &deck::slotCard(int slot, flashcard &stash) const {
+    if (storageMode == Storage::Vector) return cards.at(slot);
+
+    stash = flashcard(arena.question(slot).toString(), arena.answer(slot).toString(), arena.id(slot));
+    return stash;
+}
+
+static flashcard &threadStash() {
+    static thread_local flashcard stash;
+    return stash;
+}
+
+// Adds a card, giving it a fresh id unless it already has one that's free here
+quint64 deck::addCard(const flashcard &card){
+    return addCard(flashcard(card));
+}
+
+quint64 deck::addCard(flashcard &&card){
+    quint64 id = card.getId();
+    while (id == 0 || slots.contains(id)) id = FlashcardFactory::newId();
+
+    slots.insert(id, slotCount());
+    if (storageMode == Storage::Arena) {
+        arena.append(id, card.getQuestion(), card.getAnswer());
+    } else {
+        card.setId(id);
+        cards.append(std::move(card));
+    }
+    dirty = true;
+    return id;
+}
+
+// Appends many cards with a single reallocation
+void deck::addCards(const QVector<flashcard> &newCards){
+    if (newCards.isEmpty()) return;
+    reserve(getSize() + newCards.size());
+    for (const flashcard &card : newCards) addCard(card);
+}
+
+void deck::addCards(QVector<flashcard> &&newCards){
+    if (newCards.isEmpty()) return;
+    reserve(getSize() + newCards.size());
+    for (flashcard &card : newCards) addCard(std::move(card));
+}
+
+void deck::reserve(int size){
+    if (storageMode == Storage::Arena) arena.reserve(size + tombstones);
+    else cards.reserve(size + tombstones);
+    slots.reserve(size);
 }
 
-// Return a pointer to the card with the given index
+// Slot of the index-th live card, or -1
+int deck::slotAt(int index) const {
+    if (index < 0 || index >= getSize()) return -1;
+    if (tombstones == 0) return index;
+
+    const int n = slotCount();
+    for (int slot = 0; slot < n; ++slot) {
+        if (slotId(slot) != 0 && index-- == 0) return slot;
+    }
+    return -1;
+}
+
+// Return a copy of the card with the given index
 flashcard deck::getCard(int index) const {
-    return cards.at(index);
+    const int slot = slotAt(index);
+    if (storageMode == Storage::Vector) return cards.at(slot);
+    return flashcard(arena.question(slot).toString(), arena.answer(slot).toString(), arena.id(slot));
+}
+
+const flashcard &deck::cardAt(int index) const {
+    return slotCard(slotAt(index), threadStash());
+}
+
+QStringView deck::questionAt(int index) const {
+    const int slot = slotAt(index);
+    if (storageMode == Storage::Arena) return arena.question(slot);
+    return cards.at(slot).getQuestion();
+}
+
+QStringView deck::answerAt(int index) const {
+    const int slot = slotAt(index);
+    if (storageMode == Storage::Arena) return arena.answer(slot);
+    return cards.at(slot).getAnswer();
 }
 
 // Return deck size
 int deck::getSize() const {
-    return cards.size();
+    return slotCount() - tombstones;
 }
 
 // Return deck name
@@ -24,18 +113,17 @@ QString deck::getName() const{
 
 void deck::setName(const QString &newName) {
     name = newName;
+    dirty = true;
 }
 
 bool deck::updateCard(int index, const flashcard& card) {
-    if (index < 0 || index >= cards.size()) return false;
-    cards[index] = card;
-    return true;
+    const int slot = slotAt(index);
+    return slot >= 0 && updateCardById(slotId(slot), card);
 }
 
 bool deck::removeCard(int index) {
-    if (index < 0 || index >= cards.size()) return false;
-    cards.removeAt(index);
-    return true;
+    const int slot = slotAt(index);
+    return slot >= 0 && removeCardById(slotId(slot));
 }
 
 QString deck::getTag() const {
@@ -44,4 +132,165 @@ QString deck::getTag() const {
 
 void deck::setTag(const QString &newTag) {
     tag = newTag;
+    dirty = true;
+}
+
+QStringList deck::tags() const {
+    return splitTags(tag);
+}
+
+QStringList deck::splitTags(const QString &tag) {
+    QStringList out;
+    for (const QString &part : tag.split(',')) {
+        const QString t = part.simplified();
+        if (!t.isEmpty() && !out.contains(t, Qt::CaseInsensitive)) out.append(t);
+    }
+    return out;
+}
+
+bool deck::isDirty() const {
+    return dirty;
+}
+
+void deck::setDirty(bool d) {
+    dirty = d;
+}
+
+bool deck::contains(quint64 id) const {
+    return slots.contains(id);
+}
+
+const flashcard *deck::findCard(quint64 id) const {
+    const auto it = slots.constFind(id);
+    return it == slots.constEnd() ? nullptr : &slotCard(it.value(), threadStash());
+}
+
+flashcard deck::cardById(quint64 id) const {
+    const auto it = slots.constFind(id);
+    if (it == slots.constEnd()) return flashcard();
+    const int slot = it.value();
+    if (storageMode == Storage::Vector) return cards.at(slot);
+    return flashcard(arena.question(slot).toString(), arena.answer(slot).toString(), id);
+}
+
+quint64 deck::idAt(int index) const {
+    const int slot = slotAt(index);
+    return slot >= 0 ? slotId(slot) : 0;
+}
+
+QVector<quint64> deck::cardIds() const {
+    QVector<quint64> ids;
+    ids.reserve(getSize());
+    const int n = slotCount();
+    for (int slot = 0; slot < n; ++slot) {
+        if (const quint64 id = slotId(slot)) ids.append(id);
+    }
+    return ids;
+}
+
+bool deck::updateCardById(quint64 id, const flashcard &card) {
+    const auto it = slots.constFind(id);
+    if (it == slots.constEnd()) return false;
+
+    if (storageMode == Storage::Arena) {
+        arena.set(it.value(), card.getQuestion(), card.getAnswer());
+    } else {
+        flashcard &slot = cards[it.value()];
+        slot = card;
+        slot.setId(id);
+    }
+    dirty = true;
+    return true;
+}
+
+// Leaves a tombstone so no other card moves; compaction reclaims it later
+bool deck::removeCardById(quint64 id) {
+    const auto it = slots.find(id);
+    if (it == slots.end()) return false;
+
+    if (storageMode == Storage::Arena) arena.clear(it.value());
+    else cards[it.value()] = flashcard();
+    slots.erase(it);
+    ++tombstones;
+    dirty = true;
+    maybeCompact();
+    return true;
+}
+
+// Compacting once tombstones reach a quarter of the slots keeps removal amortized O(1)
+void deck::maybeCompact() {
+    if (tombstones >= 16 && tombstones * 4 >= slotCount()) compact();
+}
+
+void deck::compact() {
+    if (tombstones == 0) return;
+
+    if (storageMode == Storage::Arena) {
+        arena.removeTombstones();
+        for (int slot = 0; slot < arena.slotCount(); ++slot) slots[arena.id(slot)] = slot;
+        tombstones = 0;
+        return;
+    }
+
+    int out = 0;
+    for (int in = 0; in < cards.size(); ++in) {
+        if (cards[in].getId() == 0) continue;
+        if (in != out) {
+            cards[out] = std::move(cards[in]);
+            slots[cards[out].getId()] = out;
+        }
+        ++out;
+    }
+    cards.resize(out);
+    tombstones = 0;
+}
+
+// Arena storage already keeps a single copy of its text, so only the tag is pooled there
+void deck::internText(StringPool &pool) {
+    tag = pool.intern(tag);
+    if (storageMode == Storage::Arena) return;
+
+    for (flashcard &card : cards) {
+        if (card.getId() == 0) continue;
+        card.setQuestion(pool.intern(card.getQuestion()));
+        card.setAnswer(pool.intern(card.getAnswer()));
+    }
+}
+
+deck::Storage deck::storage() const {
+    return storageMode;
+}
+
+// Moves the cards into the other layout; ids and order are kept, tombstones dropped
+void deck::setStorage(Storage s) {
+    if (s == storageMode) return;
+    compact();
+
+    if (s == Storage::Arena) {
+        qint64 units = 0;
+        for (const flashcard &card : std::as_const(cards)) units += card.getQuestion().size() + card.getAnswer().size();
+        arena.reserve(cards.size(), units);
+        for (const flashcard &card : std::as_const(cards)) arena.append(card.getId(), card.getQuestion(), card.getAnswer());
+        cards = QVector<flashcard>();
+    } else {
+        cards.reserve(arena.slotCount());
+        for (int slot = 0; slot < arena.slotCount(); ++slot) {
+            cards.append(flashcard(arena.question(slot).toString(), arena.answer(slot).toString(), arena.id(slot)));
+        }
+        arena.clearAll();
+    }
+    storageMode = s;
+}
+
+// Heap estimate for the card payload: the arena's buffers, or the card vector plus
+// each QString's allocation (header + UTF-16 payload; allocator overhead not counted)
+qint64 deck::memoryBytes() const {
+    if (storageMode == Storage::Arena) return arena.memoryBytes();
+
+    auto stringBytes = [](const QString &s) -> qint64 {
+        return s.isEmpty() ? 0 : 24 + qint64(s.capacity() + 1) * qint64(sizeof(QChar));
+    };
+    qint64 bytes = qint64(cards.capacity()) * qint64(sizeof(flashcard));
+    for (const flashcard &card : cards) bytes += stringBytes(card.getQuestion()) + stringBytes(card.getAnswer());
+    return bytes;
 }
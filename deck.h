@@ -1,19 +1,88 @@
 #ifndef DECK_H
 #define DECK_H
 
+#include <QHash>
+#include <QStringList>
+#include <QStringView>
 #include <QVector>
+#include "cardarena.h"
 #include "flashcard.h"
+#include "stringpool.h"
+
+/*
+ * Every card in a deck has a non-zero id, unique within the deck, and can be
+ * looked up, updated or removed by it in O(1) through a hash index.
+ *
+ * Removing by id leaves a tombstone (an id 0 slot) instead of shifting the
+ * vector; tombstones are compacted away once they make up a quarter of it.
+ * Iteration skips them. Position-based access (getCard/cardAt/updateCard/
+ * removeCard by index) is kept for callers that think in rows; it is O(1)
+ * while there are no tombstones and a linear scan otherwise.
+ *
+ * Tags: the tag field may hold several comma-separated tags ("spanish, verbs");
+ * tags() splits them.
+ *
+ * Storage: cards live in a QVector<flashcard> by default. setStorage(Arena)
+ * moves them into a CardArena (one text buffer plus parallel arrays) behind the
+ * same API. In arena storage cardAt(), findCard() and iteration build the card
+ * on demand: the reference is only valid until the next such call on the same
+ * thread (or until the iterator advances), but its strings are owning copies and
+ * can be kept. questionAt()/answerAt() return views without copying on both
+ * layouts; those are valid until the deck changes.
+ */
 
 class deck
 {
+public:
+    enum class Storage { Vector, Arena };
+
 private:
-    QVector<flashcard> cards;
+    QVector<flashcard> cards;      // Vector storage: live cards plus tombstones (id 0), in display order
+    CardArena arena;               // Arena storage: same slots, structure-of-arrays
+    Storage storageMode = Storage::Vector;
+    QHash<quint64, int> slots;     // card id -> slot
+    int tombstones = 0;
     QString name;
     QString tag;
+    bool dirty = true;   // changed since it was last written to its shard
+
+    int slotCount() const;
+    quint64 slotId(int slot) const;
+    const flashcard &slotCard(int slot, flashcard &stash) const;
+    int slotAt(int index) const;
+    void maybeCompact();
+
 public:
+    class const_iterator
+    {
+    public:
+        const_iterator(const deck *d, int slot) : m_deck(d), m_slot(slot) { skipTombstones(); }
+
+        const flashcard &operator*() const { return m_deck->slotCard(m_slot, m_stash); }
+        const flashcard *operator->() const { return &**this; }
+        const_iterator &operator++() { ++m_slot; skipTombstones(); return *this; }
+        bool operator==(const const_iterator &o) const { return m_slot == o.m_slot; }
+        bool operator!=(const const_iterator &o) const { return m_slot != o.m_slot; }
+
+    private:
+        void skipTombstones() { while (m_slot < m_deck->slotCount() && m_deck->slotId(m_slot) == 0) ++m_slot; }
+        const deck *m_deck;
+        int m_slot;
+        mutable flashcard m_stash;   // arena storage only
+    };
+
     deck(const QString &name = "Untitled Deck", const QString &tag = "");
-    void addCard(const flashcard &card);
+    quint64 addCard(const flashcard &card);   // returns the id (assigned if 0 or taken)
+    quint64 addCard(flashcard &&card);
+    void addCards(const QVector<flashcard> &newCards);
+    void addCards(QVector<flashcard> &&newCards);
+    void reserve(int size);
     flashcard getCard(int index) const;
+    const flashcard &cardAt(int index) const;   // see Storage above for how long it stays valid
+    QStringView questionAt(int index) const;    // valid until the deck changes
+    QStringView answerAt(int index) const;
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, slotCount()); }
     int getSize() const;
     QString getName() const;
     void setName(const QString &newName);
@@ -21,6 +90,26 @@ public:
     bool removeCard(int index);
     QString getTag() const;
     void setTag(const QString &newTag);
+    QStringList tags() const;
+    static QStringList splitTags(const QString &tag);
+    bool isDirty() const;
+    void setDirty(bool d);
+
+    // Id-based access
+    bool contains(quint64 id) const;
+    const flashcard *findCard(quint64 id) const;   // nullptr if there is no such card
+    flashcard cardById(quint64 id) const;
+    quint64 idAt(int index) const;
+    QVector<quint64> cardIds() const;
+    bool updateCardById(quint64 id, const flashcard &card);   // card keeps its id
+    bool removeCardById(quint64 id);
+    void compact();
+    void internText(StringPool &pool);   // shares tag/card text through pool; content unchanged
+
+    // Storage layout
+    Storage storage() const;
+    void setStorage(Storage s);
+    qint64 memoryBytes() const;
 };
 
 #endif // DECK_H
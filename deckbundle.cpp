@@ -0,0 +1,210 @@
+#include "deckbundle.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QtEndian>
+#include <cstring>
+
+static const char Magic[4] = { 'F', 'C', 'B', 'Z' };
+static const qint64 HeaderSize = 16;
+static const qint64 FooterSize = 16;
+static const int EntryFixedSize = 24;
+
+static void appendU32(QByteArray &out, quint32 v)
+{
+    uchar buf[4];
+    qToLittleEndian<quint32>(v, buf);
+    out.append(reinterpret_cast<const char *>(buf), 4);
+}
+
+static void appendU64(QByteArray &out, quint64 v)
+{
+    uchar buf[8];
+    qToLittleEndian<quint64>(v, buf);
+    out.append(reinterpret_cast<const char *>(buf), 8);
+}
+
+static quint32 readU32(const char *p)
+{
+    return qFromLittleEndian<quint32>(p);
+}
+
+static quint64 readU64(const char *p)
+{
+    return qFromLittleEndian<quint64>(p);
+}
+
+// ---------------------------------------------------------
+// DeckBundleWriter
+// ---------------------------------------------------------
+
+DeckBundleWriter::DeckBundleWriter(const QString &path, int compressionLevel)
+    : m_file(path), m_level(compressionLevel)
+{
+}
+
+bool DeckBundleWriter::open(QString *errorOut)
+{
+    QDir().mkpath(QFileInfo(m_file.fileName()).absolutePath());
+    if (!m_file.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for writing.").arg(m_file.fileName());
+        return false;
+    }
+
+    QByteArray header(Magic, 4);
+    appendU32(header, DeckBundleReader::Version);
+    appendU32(header, 0);
+    appendU32(header, 0);
+    m_pos = quint64(m_file.write(header));
+    return m_pos == quint64(HeaderSize);
+}
+
+bool DeckBundleWriter::addBlock(const QString &name, int cardCount, const QByteArray &json)
+{
+    const QByteArray block = qCompress(json, m_level);
+    if (m_file.write(block) != block.size()) return false;
+
+    DeckBundleEntry e;
+    e.name = name;
+    e.cardCount = cardCount;
+    e.offset = m_pos;
+    e.compressedSize = quint32(block.size());
+    e.rawSize = quint32(json.size());
+    m_entries.append(e);
+
+    m_pos += quint64(block.size());
+    m_rawBytes += json.size();
+    m_compressedBytes += block.size();
+    return true;
+}
+
+bool DeckBundleWriter::finish(QString *errorOut)
+{
+    QByteArray tail;
+    for (const DeckBundleEntry &e : m_entries) {
+        const QByteArray name = e.name.toUtf8();
+        appendU64(tail, e.offset);
+        appendU32(tail, e.compressedSize);
+        appendU32(tail, e.rawSize);
+        appendU32(tail, quint32(e.cardCount));
+        appendU32(tail, quint32(name.size()));
+        tail.append(name);
+    }
+    appendU64(tail, m_pos);
+    appendU32(tail, quint32(m_entries.size()));
+    tail.append(Magic, 4);
+
+    if (m_file.write(tail) != tail.size() || !m_file.commit()) {
+        if (errorOut) *errorOut = QString("Could not write %1.").arg(m_file.fileName());
+        return false;
+    }
+    return true;
+}
+
+void DeckBundleWriter::cancel()
+{
+    m_file.cancelWriting();
+}
+
+// ---------------------------------------------------------
+// DeckBundleReader
+// ---------------------------------------------------------
+
+bool DeckBundleReader::open(const QString &path, QString *errorOut)
+{
+    close();
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for reading.").arg(path);
+        return false;
+    }
+
+    auto fail = [&](const QString &message) {
+        if (errorOut) *errorOut = message.arg(path);
+        close();
+        return false;
+    };
+
+    const qint64 size = m_file.size();
+    const QByteArray header = m_file.read(HeaderSize);
+    if (size < HeaderSize + FooterSize || header.size() != HeaderSize
+        || std::memcmp(header.constData(), Magic, 4) != 0 || readU32(header.constData() + 4) != Version) {
+        return fail("%1 is not a supported deck bundle.");
+    }
+
+    m_file.seek(size - FooterSize);
+    const QByteArray footer = m_file.read(FooterSize);
+    if (footer.size() != FooterSize || std::memcmp(footer.constData() + 12, Magic, 4) != 0) {
+        return fail("%1 is truncated.");
+    }
+    const quint64 dirOffset = readU64(footer.constData());
+    const quint32 count = readU32(footer.constData() + 8);
+    if (dirOffset < quint64(HeaderSize) || dirOffset > quint64(size - FooterSize)) {
+        return fail("%1 is truncated.");
+    }
+
+    m_file.seek(qint64(dirOffset));
+    const QByteArray dir = m_file.read(size - FooterSize - qint64(dirOffset));
+    const char *p = dir.constData();
+    const char *end = p + dir.size();
+
+    m_entries.reserve(int(qMin<quint32>(count, quint32(dir.size() / EntryFixedSize))));
+    for (quint32 i = 0; i < count; ++i) {
+        if (end - p < EntryFixedSize) return fail("%1 has a damaged directory.");
+        DeckBundleEntry e;
+        e.offset = readU64(p);
+        e.compressedSize = readU32(p + 8);
+        e.rawSize = readU32(p + 12);
+        e.cardCount = int(readU32(p + 16));
+        const quint32 nameBytes = readU32(p + 20);
+        p += EntryFixedSize;
+        if (quint64(end - p) < nameBytes || e.offset + e.compressedSize > dirOffset) {
+            return fail("%1 has a damaged directory.");
+        }
+        e.name = QString::fromUtf8(p, int(nameBytes));
+        p += nameBytes;
+        m_entries.append(e);
+    }
+    return true;
+}
+
+void DeckBundleReader::close()
+{
+    m_file.close();
+    m_entries.clear();
+}
+
+int DeckBundleReader::indexOf(const QString &name) const
+{
+    for (int i = 0; i < m_entries.size(); ++i) {
+        if (m_entries[i].name == name) return i;
+    }
+    return -1;
+}
+
+bool DeckBundleReader::readBlock(int index, QByteArray &json, QString *errorOut)
+{
+    if (index < 0 || index >= m_entries.size()) {
+        if (errorOut) *errorOut = "Deck not found in bundle.";
+        return false;
+    }
+
+    const DeckBundleEntry &e = m_entries[index];
+    m_file.seek(qint64(e.offset));
+    const QByteArray block = m_file.read(e.compressedSize);
+    json = block.size() == int(e.compressedSize) ? qUncompress(block) : QByteArray();
+    if (json.size() != int(e.rawSize)) {
+        if (errorOut) *errorOut = QString("Deck %1 is damaged in the bundle.").arg(e.name);
+        return false;
+    }
+    return true;
+}
+
+bool DeckBundleReader::isBundle(const QString &path)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+    const QByteArray head = f.read(4);
+    return head.size() == 4 && std::memcmp(head.constData(), Magic, 4) == 0;
+}
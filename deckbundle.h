@@ -0,0 +1,89 @@
+#ifndef DECKBUNDLE_H
+#define DECKBUNDLE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QSaveFile>
+#include <QString>
+#include <QVector>
+
+/*
+ * DeckBundle (.fcbz compressed export/import, version 1)
+ *
+ * Layout (little-endian):
+ *   header     "FCBZ", quint32 version, quint32 flags (0), quint32 reserved (0)
+ *   blocks     one qCompress()ed block per deck; each inflates to the single-deck
+ *              export JSON, so an extracted block is a valid .json deck file
+ *   directory  per deck: quint64 offset, quint32 compressedSize, quint32 rawSize,
+ *              quint32 cardCount, quint32 nameBytes, name (UTF-8)
+ *   footer     quint64 directoryOffset, quint32 deckCount, "FCBZ"
+ *
+ * Blocks are independent, so one deck can be pulled out of a large bundle by
+ * reading the directory and inflating just that block. The directory trails the
+ * blocks so the writer only ever holds one deck in memory.
+ */
+
+struct DeckBundleEntry
+{
+    QString name;
+    int cardCount = 0;
+    quint64 offset = 0;
+    quint32 compressedSize = 0;
+    quint32 rawSize = 0;
+};
+
+struct DeckBundleStats
+{
+    qint64 rawBytes = 0;          // JSON bytes before compression / after inflation
+    qint64 compressedBytes = 0;   // block bytes in the file
+    qint64 elapsedMs = 0;
+
+    double ratio() const { return compressedBytes > 0 ? double(rawBytes) / compressedBytes : 0.0; }
+    double megabytesPerSecond() const { return elapsedMs > 0 ? rawBytes / 1048.576 / elapsedMs : 0.0; }
+};
+
+class DeckBundleWriter
+{
+public:
+    explicit DeckBundleWriter(const QString &path, int compressionLevel = -1);
+
+    bool open(QString *errorOut = nullptr);
+    bool addBlock(const QString &name, int cardCount, const QByteArray &json);
+    bool finish(QString *errorOut = nullptr);   // writes directory + footer and commits
+    void cancel();                              // leaves any existing file untouched
+
+    qint64 rawBytes() const { return m_rawBytes; }
+    qint64 compressedBytes() const { return m_compressedBytes; }
+
+private:
+    QSaveFile m_file;
+    int m_level;
+    quint64 m_pos = 0;
+    qint64 m_rawBytes = 0;
+    qint64 m_compressedBytes = 0;
+    QVector<DeckBundleEntry> m_entries;
+};
+
+class DeckBundleReader
+{
+public:
+    static const quint32 Version = 1;
+
+    bool open(const QString &path, QString *errorOut = nullptr);
+    void close();
+
+    int deckCount() const { return m_entries.size(); }
+    const DeckBundleEntry &entry(int index) const { return m_entries.at(index); }
+    int indexOf(const QString &name) const;
+
+    // Reads and inflates one block
+    bool readBlock(int index, QByteArray &json, QString *errorOut = nullptr);
+
+    static bool isBundle(const QString &path);   // checks the magic only
+
+private:
+    QFile m_file;
+    QVector<DeckBundleEntry> m_entries;
+};
+
+#endif // DECKBUNDLE_H
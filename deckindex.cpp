@@ -0,0 +1,73 @@
+#include "deckindex.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+bool DeckIndex::write(const QString &path, qint64 seq, const QVector<DeckIndexEntry> &entries, QString *errorOut)
+{
+    QJsonArray arr;
+    for (const DeckIndexEntry &e : entries) {
+        QJsonObject o;
+        o["name"] = e.name;
+        o["tag"] = e.tag;
+        o["cards"] = e.cardCount;
+        o["file"] = e.file;
+        arr.append(o);
+    }
+
+    QJsonObject root;
+    root["version"] = 2;
+    root["seq"] = double(seq);
+    root["decks"] = arr;
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for writing.").arg(path);
+        return false;
+    }
+    f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!f.commit()) {
+        if (errorOut) *errorOut = QString("Could not write %1.").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool DeckIndex::read(const QString &path, qint64 *seqOut, QVector<DeckIndexEntry> &entries)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+    if (!doc.isObject()) return false;
+
+    const QJsonObject root = doc.object();
+    if (seqOut) *seqOut = qint64(root.value("seq").toDouble());
+
+    const QJsonArray arr = root.value("decks").toArray();
+    entries.clear();
+    entries.reserve(arr.size());
+    for (const auto &v : arr) {
+        const QJsonObject o = v.toObject();
+        DeckIndexEntry e;
+        e.name = o.value("name").toString();
+        e.tag = o.value("tag").toString();
+        e.cardCount = o.value("cards").toInt();
+        e.file = o.value("file").toString();
+        entries.append(e);
+    }
+    return true;
+}
+
+QString DeckIndex::shardFileName(const QString &deckName)
+{
+    const QByteArray hash = QCryptographicHash::hash(deckName.toUtf8(), QCryptographicHash::Sha1);
+    return QString::fromLatin1(hash.toHex().left(20)) + ".json";
+}
@@ -0,0 +1,37 @@
+#ifndef DECKINDEX_H
+#define DECKINDEX_H
+
+#include <QString>
+#include <QVector>
+
+/*
+ * DeckIndex (decks/manifest.json, the manifest of the sharded layout)
+ *
+ *  - Every deck lives in its own shard file under decks/; the manifest holds one
+ *    entry per deck: name, tag, card count and shard file name.
+ *  - Startup only reads the manifest; a deck's shard is parsed the first time
+ *    the deck is requested.
+ *  - The manifest is written after the shards it references, and carries the
+ *    journal seq it is current up to.
+ */
+
+struct DeckIndexEntry
+{
+    QString name;
+    QString tag;
+    int cardCount = 0;
+    QString file;
+};
+
+class DeckIndex
+{
+public:
+    static bool write(const QString &path, qint64 seq, const QVector<DeckIndexEntry> &entries,
+                      QString *errorOut = nullptr);
+    static bool read(const QString &path, qint64 *seqOut, QVector<DeckIndexEntry> &entries);
+
+    // Stable shard file name for a deck (hash of the name, so any name is a valid file name)
+    static QString shardFileName(const QString &deckName);
+};
+
+#endif // DECKINDEX_H
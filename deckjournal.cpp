@@ -0,0 +1,117 @@
+#include "deckjournal.h"
+
+#include <QDir>
+#include <QFileInfo>
+#include <QJsonDocument>
+
+DeckJournal::DeckJournal(const QString &path) : m_path(path) {}
+
+void DeckJournal::setPath(const QString &path)
+{
+    if (m_file.isOpen()) m_file.close();
+    m_path = path;
+}
+
+QString DeckJournal::path() const
+{
+    return m_path;
+}
+
+QString DeckJournal::rotatedPath() const
+{
+    return m_path + ".1";
+}
+
+bool DeckJournal::ensureOpen(QString *errorOut)
+{
+    if (m_file.isOpen()) return true;
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for appending.").arg(m_path);
+        return false;
+    }
+    return true;
+}
+
+// Appends one record as a single line and flushes it to the OS
+bool DeckJournal::append(const QJsonObject &record, QString *errorOut)
+{
+    if (!ensureOpen(errorOut)) return false;
+
+    QByteArray line = QJsonDocument(record).toJson(QJsonDocument::Compact);
+    line.append('\n');
+    if (m_file.write(line) != line.size() || !m_file.flush()) {
+        if (errorOut) *errorOut = QString("Could not write to %1.").arg(m_path);
+        return false;
+    }
+    return true;
+}
+
+void DeckJournal::readFile(const QString &path, QVector<QJsonObject> &out)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return;
+
+    while (!f.atEnd()) {
+        const QByteArray line = f.readLine().trimmed();
+        if (line.isEmpty()) continue;
+
+        const QJsonDocument doc = QJsonDocument::fromJson(line);
+        // A torn last line (crash mid-append) ends the usable part of the log
+        if (!doc.isObject()) break;
+        out.append(doc.object());
+    }
+}
+
+QVector<QJsonObject> DeckJournal::readAll() const
+{
+    QVector<QJsonObject> records;
+    readFile(rotatedPath(), records);
+    readFile(m_path, records);
+    return records;
+}
+
+qint64 DeckJournal::size() const
+{
+    if (m_file.isOpen()) return m_file.size();
+    return QFileInfo(m_path).size();
+}
+
+// Moves the live journal aside. If an older rotated file is still around
+// (e.g. the last compaction failed) the live records are appended to it.
+bool DeckJournal::rotate(QString *errorOut)
+{
+    if (m_file.isOpen()) m_file.close();
+    if (!QFile::exists(m_path)) return true;
+
+    if (!QFile::exists(rotatedPath())) {
+        if (QFile::rename(m_path, rotatedPath())) return true;
+    } else {
+        QFile src(m_path);
+        QFile dst(rotatedPath());
+        if (src.open(QIODevice::ReadOnly) && dst.open(QIODevice::WriteOnly | QIODevice::Append)) {
+            if (dst.write(src.readAll()) >= 0) {
+                src.close();
+                QFile::remove(m_path);
+                return true;
+            }
+        }
+    }
+
+    if (errorOut) *errorOut = QString("Could not rotate %1.").arg(m_path);
+    return false;
+}
+
+void DeckJournal::discardRotated()
+{
+    QFile::remove(rotatedPath());
+}
+
+void DeckJournal::clear()
+{
+    if (m_file.isOpen()) m_file.close();
+    QFile::remove(m_path);
+    discardRotated();
+}
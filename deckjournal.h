@@ -0,0 +1,45 @@
+#ifndef DECKJOURNAL_H
+#define DECKJOURNAL_H
+
+#include <QFile>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+/*
+ * DeckJournal (append-only change log, decks.journal next to the decks/ shards)
+ *
+ *  - Every deck/card mutation is appended as one compact JSON object per line,
+ *    so a save costs the size of the change instead of the whole library.
+ *  - Records carry a "seq" number; decks/manifest.json and every shard store the
+ *    last seq they contain, so replay can skip records that were already compacted.
+ *  - rotate() moves the live journal aside while the dirty shards and the manifest
+ *    are written in the background; the rotated file is dropped once they are on disk.
+ */
+
+class DeckJournal
+{
+public:
+    explicit DeckJournal(const QString &path = QString());
+
+    void setPath(const QString &path);
+    QString path() const;
+    QString rotatedPath() const;
+
+    bool append(const QJsonObject &record, QString *errorOut = nullptr);
+    QVector<QJsonObject> readAll() const; // rotated records first, then live ones
+    qint64 size() const;
+
+    bool rotate(QString *errorOut = nullptr);
+    void discardRotated();
+    void clear();
+
+private:
+    bool ensureOpen(QString *errorOut);
+    static void readFile(const QString &path, QVector<QJsonObject> &out);
+
+    QString m_path;
+    QFile m_file;
+};
+
+#endif // DECKJOURNAL_H
@@ -0,0 +1,214 @@
+#include "deckpatch.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+
+static const char *const Format = "fcpatch";
+static const int Version = 1;
+
+quint64 DeckPatch::cardHash(QStringView question, QStringView answer)
+{
+    // FNV-1a over question, a separator, then answer, so moving text between the two changes the hash
+    quint64 h = 1469598103934665603ULL;
+    auto feed = [&h](QStringView s) {
+        for (const QChar c : s) {
+            h ^= c.unicode();
+            h *= 1099511628211ULL;
+        }
+    };
+    feed(question);
+    h ^= 0xFFFF;
+    h *= 1099511628211ULL;
+    feed(answer);
+    return h;
+}
+
+DeckPatch DeckPatch::diff(const deck &base, const deck &target)
+{
+    DeckPatch patch;
+    patch.deckName = target.getName();
+    if (base.getTag() != target.getTag()) {
+        patch.tagChanged = true;
+        patch.tag = target.getTag();
+    }
+
+    QHash<quint64, quint64> baseHashes;   // id -> content hash
+    baseHashes.reserve(base.getSize());
+    for (const flashcard &fc : base) baseHashes.insert(fc.getId(), cardHash(fc.getQuestion(), fc.getAnswer()));
+
+    for (const flashcard &fc : target) {
+        const quint64 h = cardHash(fc.getQuestion(), fc.getAnswer());
+        auto it = baseHashes.find(fc.getId());
+        if (it != baseHashes.end() && it.value() == h) {
+            baseHashes.erase(it);
+            continue;
+        }
+
+        DeckPatchRecord r;
+        r.id = fc.getId();
+        r.question = fc.getQuestion();
+        r.answer = fc.getAnswer();
+        if (it != baseHashes.end()) {
+            r.op = DeckPatchRecord::Modify;
+            r.baseHash = it.value();
+            baseHashes.erase(it);
+        }
+        patch.records.append(r);
+    }
+
+    // Whatever is left of the base is gone from the target; keep base order
+    for (const flashcard &fc : base) {
+        auto it = baseHashes.constFind(fc.getId());
+        if (it == baseHashes.constEnd()) continue;
+        DeckPatchRecord r;
+        r.op = DeckPatchRecord::Delete;
+        r.id = fc.getId();
+        r.baseHash = it.value();
+        patch.records.append(r);
+    }
+    return patch;
+}
+
+int DeckPatch::count(DeckPatchRecord::Op op) const
+{
+    int n = 0;
+    for (const DeckPatchRecord &r : records) n += r.op == op;
+    return n;
+}
+
+bool DeckPatch::check(const deck &d, QString *errorOut) const
+{
+    auto fail = [&](const DeckPatchRecord &r, const char *why) {
+        if (errorOut) *errorOut = QString("Patch does not match deck %1: card %2 %3.").arg(d.getName()).arg(r.id).arg(QLatin1String(why));
+        return false;
+    };
+
+    for (const DeckPatchRecord &r : records) {
+        const flashcard *fc = d.findCard(r.id);
+        if (r.op == DeckPatchRecord::Add) {
+            if (fc && cardHash(fc->getQuestion(), fc->getAnswer()) != cardHash(r.question, r.answer)) {
+                return fail(r, "already exists with different text");
+            }
+            continue;
+        }
+        if (!fc) return fail(r, "is missing");
+        if (cardHash(fc->getQuestion(), fc->getAnswer()) != r.baseHash) return fail(r, "has been edited");
+    }
+    return true;
+}
+
+void DeckPatch::apply(deck &d) const
+{
+    for (const DeckPatchRecord &r : records) {
+        switch (r.op) {
+        case DeckPatchRecord::Add:
+            if (!d.contains(r.id)) d.addCard(flashcard(r.question, r.answer, r.id));   // present = already applied
+            break;
+        case DeckPatchRecord::Modify:
+            d.updateCardById(r.id, flashcard(r.question, r.answer));
+            break;
+        case DeckPatchRecord::Delete:
+            d.removeCardById(r.id);
+            break;
+        }
+    }
+    if (tagChanged) d.setTag(tag);
+}
+
+QJsonObject DeckPatch::toJson() const
+{
+    QJsonArray changes;
+    for (const DeckPatchRecord &r : records) {
+        QJsonObject c;
+        c["op"] = r.op == DeckPatchRecord::Add ? "add" : r.op == DeckPatchRecord::Modify ? "modify" : "delete";
+        c["id"] = QString::number(r.id);
+        if (r.op != DeckPatchRecord::Delete) {
+            c["question"] = r.question;
+            c["answer"] = r.answer;
+        }
+        if (r.op != DeckPatchRecord::Add) c["base"] = QString::number(r.baseHash, 16);
+        changes.append(c);
+    }
+
+    QJsonObject o;
+    o["format"] = Format;
+    o["version"] = Version;
+    o["deck"] = deckName;
+    if (tagChanged) o["tag"] = tag;
+    o["changes"] = changes;
+    return o;
+}
+
+bool DeckPatch::fromJson(const QJsonObject &o, DeckPatch &out, QString *errorOut)
+{
+    if (o.value("format").toString() != Format || o.value("version").toInt() != Version) {
+        if (errorOut) *errorOut = "Not a supported deck patch.";
+        return false;
+    }
+
+    out = DeckPatch();
+    out.deckName = o.value("deck").toString();
+    out.tagChanged = o.contains("tag");
+    out.tag = o.value("tag").toString();
+
+    const QJsonArray changes = o.value("changes").toArray();
+    out.records.reserve(changes.size());
+    for (const QJsonValue &v : changes) {
+        const QJsonObject c = v.toObject();
+        const QString op = c.value("op").toString();
+        DeckPatchRecord r;
+        if (op == "add") r.op = DeckPatchRecord::Add;
+        else if (op == "modify") r.op = DeckPatchRecord::Modify;
+        else if (op == "delete") r.op = DeckPatchRecord::Delete;
+        else {
+            if (errorOut) *errorOut = QString("Unknown patch operation \"%1\".").arg(op);
+            return false;
+        }
+        r.id = c.value("id").toString().toULongLong();
+        r.question = c.value("question").toString();
+        r.answer = c.value("answer").toString();
+        r.baseHash = c.value("base").toString().toULongLong(nullptr, 16);
+        if (r.id == 0) {
+            if (errorOut) *errorOut = "Patch record without a card id.";
+            return false;
+        }
+        out.records.append(r);
+    }
+    return true;
+}
+
+bool DeckPatch::write(const QString &path, QString *errorOut) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for writing.").arg(path);
+        return false;
+    }
+    const QByteArray data = QJsonDocument(toJson()).toJson(QJsonDocument::Compact);
+    if (f.write(data) != data.size() || !f.commit()) {
+        if (errorOut) *errorOut = QString("Could not write %1.").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool DeckPatch::read(const QString &path, DeckPatch &out, QString *errorOut)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for reading.").arg(path);
+        return false;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+    if (!doc.isObject()) {
+        if (errorOut) *errorOut = QString("Invalid JSON in %1.").arg(path);
+        return false;
+    }
+    return fromJson(doc.object(), out, errorOut);
+}
@@ -0,0 +1,61 @@
+#ifndef DECKPATCH_H
+#define DECKPATCH_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+#include "deck.h"
+
+/*
+ * DeckPatch (.fcpatch delta between two versions of a deck)
+ *
+ *  - diff() pairs cards by id and compares a 64-bit content hash of question and
+ *    answer, emitting add/modify/delete records only for cards that changed.
+ *  - Modify and delete records carry the hash of the card they expect to find,
+ *    so check() can refuse a patch made against a different version of the deck
+ *    by looking at the touched cards only.
+ *  - A patch is applied all or nothing: check() first, then apply(). Both cost
+ *    the number of records, not the size of the deck.
+ *
+ * File (compact JSON):
+ *   {"format":"fcpatch","version":1,"deck":name,["tag":newTag,]
+ *    "changes":[{"op":"add"|"modify"|"delete","id":"<decimal>",
+ *                ["question":q,"answer":a,]["base":"<hex hash>"]}, ...]}
+ */
+
+struct DeckPatchRecord
+{
+    enum Op { Add, Modify, Delete };
+
+    Op op = Add;
+    quint64 id = 0;
+    QString question;      // Add/Modify
+    QString answer;
+    quint64 baseHash = 0;  // Modify/Delete: hash of the card being replaced
+};
+
+class DeckPatch
+{
+public:
+    QString deckName;
+    bool tagChanged = false;
+    QString tag;
+    QVector<DeckPatchRecord> records;
+
+    static DeckPatch diff(const deck &base, const deck &target);
+    static quint64 cardHash(QStringView question, QStringView answer);
+
+    bool isEmpty() const { return records.isEmpty() && !tagChanged; }
+    int count(DeckPatchRecord::Op op) const;
+
+    bool check(const deck &d, QString *errorOut = nullptr) const;
+    void apply(deck &d) const;   // call check() first
+
+    QJsonObject toJson() const;
+    static bool fromJson(const QJsonObject &o, DeckPatch &out, QString *errorOut = nullptr);
+
+    bool write(const QString &path, QString *errorOut = nullptr) const;
+    static bool read(const QString &path, DeckPatch &out, QString *errorOut = nullptr);
+};
+
+#endif // DECKPATCH_H
@@ -5,6 +5,7 @@
 #include "studywindow.h"
 #include "statstracker.h"
 #include "flashcardmanager.h"
+#include "instrumentation.h"
 
 #include <QMessageBox>
 
@@ -45,16 +46,25 @@ DeckWindow::~DeckWindow() {
 void DeckWindow::rebuildList(int keepIndex)
 {
     if (!m_deck) return;
+    ScopedTimer timer("deck.rebuildList", "ui");
 
     QStringList items;
     const int n = m_deck->getSize();
-
-    for (int i = 0; i < n; ++i) {
-        flashcard fc = m_deck->getCard(i);
-        QString display = QString("Q: %1\nA: %2")
-                              .arg(fc.getQuestion())
-                              .arg(fc.getAnswer());
+    Instrumentation::instance().counter("deck.rows", n);
+    items.reserve(n);
+    m_rowIds.clear();
+    m_rowIds.reserve(n);
+
+    // One allocation per row: sized up front and appended in place
+    for (const flashcard &fc : *m_deck) {
+        QString display;
+        display.reserve(7 + fc.getQuestion().size() + fc.getAnswer().size());
+        display += QLatin1String("Q: ");
+        display += fc.getQuestion();
+        display += QLatin1String("\nA: ");
+        display += fc.getAnswer();
         items << display;
+        m_rowIds.append(fc.getId());
     }
 
     m_model->setStringList(items);
@@ -92,15 +102,27 @@ void DeckWindow::setCurrentIndex(int i)
 
 void DeckWindow::loadFieldsFromCurrent()
 {
-    if (!m_deck || m_current < 0 || m_current >= m_deck->getSize()) {
+    const flashcard *fc = m_deck ? m_deck->findCard(currentCardId()) : nullptr;
+    if (!fc) {
         ui->lineEditQuestion->clear();
         ui->textEditAnswer->clear();
         return;
     }
 
-    flashcard fc = m_deck->getCard(m_current);
-    ui->lineEditQuestion->setText(fc.getQuestion());
-    ui->textEditAnswer->setPlainText(fc.getAnswer());
+    ui->lineEditQuestion->setText(fc->getQuestion());
+    ui->textEditAnswer->setPlainText(fc->getAnswer());
+}
+
+void DeckWindow::selectCard(quint64 id)
+{
+    const int row = m_rowIds.indexOf(id);
+    if (row >= 0) setCurrentIndex(row);
+}
+
+// Id of the card in the selected row; rows are re-read after every change
+quint64 DeckWindow::currentCardId() const
+{
+    return (m_current >= 0 && m_current < m_rowIds.size()) ? m_rowIds[m_current] : 0;
 }
 
 // ---------------------------------------------------------
@@ -121,8 +143,7 @@ void DeckWindow::onAddButtonClicked()
     }
 
 
-    m_deck->addCard(newCard);
-    flashcardManager::instance().saveToDisk(nullptr);
+    flashcardManager::instance().addCard(m_deck->getName(), newCard);
     StatsTracker::instance().trackCardCreated();
     rebuildList(m_deck->getSize() - 1);
 
@@ -143,7 +164,7 @@ void DeckWindow::onUpdateButtonClicked()
         return;
     }
 
-    m_deck->updateCard(m_current, fc);
+    flashcardManager::instance().updateCardById(m_deck->getName(), currentCardId(), fc);
     rebuildList(m_current);
 }
 
@@ -151,7 +172,7 @@ void DeckWindow::onDeleteButtonClicked()
 {
     if (!m_deck || m_current < 0) return;
 
-    m_deck->removeCard(m_current);
+    flashcardManager::instance().removeCardById(m_deck->getName(), currentCardId());
     int nextIndex = m_current;
     if (nextIndex >= m_deck->getSize()) nextIndex = m_deck->getSize() - 1;
     rebuildList(nextIndex);
@@ -162,9 +183,19 @@ void DeckWindow::onStudyButtonClicked()
 
     if (!m_deck) return;
 
+    QMessageBox ask(QMessageBox::Question, "Study", "Study the cards that are due, or the whole deck in order?",
+                    QMessageBox::Cancel, this);
+    QPushButton *dueButton = ask.addButton("Due Cards", QMessageBox::AcceptRole);
+    QPushButton *allButton = ask.addButton("Whole Deck", QMessageBox::AcceptRole);
+    ask.exec();
+    if (ask.clickedButton() != dueButton && ask.clickedButton() != allButton) return;
+    const auto mode = ask.clickedButton() == dueButton ? ::studywindow::Mode::Due : ::studywindow::Mode::Sequential;
+
     // Create the study window if it doesn’t exist yet
     if (!studywindow) {
-        studywindow = new class::studywindow(m_deck, nullptr);
+        studywindow = new class::studywindow(m_deck, nullptr, mode);
+    } else {
+        studywindow->setMode(mode);
     }
     //studywindow->setAttribute(Qt::WA_DeleteOnClose);
     studywindow->show();
@@ -23,6 +23,8 @@ public:
     explicit DeckWindow(deck* d, QWidget* parent = nullptr);
     ~DeckWindow();
 
+    void selectCard(quint64 id);
+
 private slots:
     // --- CRUD operations ---
     void onAddButtonClicked();
@@ -44,11 +46,13 @@ private:
     void rebuildList(int keepIndex = -1);   // repopulate the list view
     void loadFieldsFromCurrent();
     void setCurrentIndex(int i);
+    quint64 currentCardId() const;
 
 private:
     Ui::DeckWindow* ui;
     deck* m_deck = nullptr;
     int m_current = -1;
+    QVector<quint64> m_rowIds;              // card id shown in each list row
     studywindow* studywindow;
 
     QStringListModel* m_model = nullptr;    // <-- model for the QListView
@@ -0,0 +1,180 @@
+#include "duplicatefinder.h"
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <numeric>
+
+static const int Slots = 64;
+static const int Bands = 16;
+static const int Rows = Slots / Bands;
+static const int ShingleLength = 4;
+static const int ChunkSize = 2048;
+static const QChar FieldSeparator(0x1F);
+
+// splitmix64 finalizer
+static quint64 mix(quint64 x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Case-folded letters and digits, one space between words
+static void appendNormalized(QString &out, const QString &text)
+{
+    bool gap = false;
+    for (const QChar c : text) {
+        if (!c.isLetterOrNumber()) {
+            gap = true;
+            continue;
+        }
+        if (gap && !out.isEmpty() && out.back() != FieldSeparator) out.append(' ');
+        gap = false;
+        out.append(c.toCaseFolded());
+    }
+}
+
+static void sign(const DuplicateFinder::Card &card, quint32 *sig)
+{
+    QString text;
+    text.reserve(card.question.size() + card.answer.size() + 1);
+    appendNormalized(text, card.question);
+    text.append(FieldSeparator);
+    appendNormalized(text, card.answer);
+
+    std::fill(sig, sig + Slots, 0xFFFFFFFFu);
+    const QChar *p = text.constData();
+    const int n = text.size();
+    const int shingles = qMax(1, n - ShingleLength + 1);
+    for (int i = 0; i < shingles; ++i) {
+        quint64 h = 1469598103934665603ULL;   // FNV-1a of the shingle
+        for (int j = i; j < qMin(n, i + ShingleLength); ++j) {
+            h ^= p[j].unicode();
+            h *= 1099511628211ULL;
+        }
+        // Each 64-bit permutation fills two 32-bit slots
+        for (int s = 0; s < Slots / 2; ++s) {
+            const quint64 v = mix(h ^ (quint64(s + 1) * 0x9E3779B97F4A7C15ULL));
+            sig[2 * s] = qMin(sig[2 * s], quint32(v));
+            sig[2 * s + 1] = qMin(sig[2 * s + 1], quint32(v >> 32));
+        }
+    }
+}
+
+QVector<DuplicateCluster> DuplicateFinder::find(const QVector<Card> &cards, double threshold,
+                                                DuplicateScanStats *stats, const Progress &progress, int maxThreads)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    const int n = cards.size();
+    QVector<quint32> signatures(n * Slots);
+    quint32 *out = signatures.data();
+
+    std::atomic<bool> cancelled{false};
+    std::atomic<qint64> done{0};
+    QMutex progressMutex;
+
+    QThreadPool pool;
+    if (maxThreads > 0) pool.setMaxThreadCount(maxThreads);
+    for (int start = 0; start < n; start += ChunkSize) {
+        pool.start([&, start]() {
+            if (cancelled.load()) return;
+            const int end = qMin(n, start + ChunkSize);
+            for (int i = start; i < end; ++i) sign(cards[i], out + i * Slots);
+
+            const qint64 finished = done += end - start;
+            if (progress) {
+                QMutexLocker lock(&progressMutex);
+                if (!progress(finished, n)) cancelled = true;
+            }
+        });
+    }
+    pool.waitForDone();
+
+    if (cancelled.load()) {
+        if (stats) *stats = DuplicateScanStats();
+        return QVector<DuplicateCluster>();
+    }
+    const qint64 signMs = timer.elapsed();
+
+    auto agreement = [&](int a, int b) {
+        const quint32 *x = out + a * Slots;
+        const quint32 *y = out + b * Slots;
+        int same = 0;
+        for (int s = 0; s < Slots; ++s) same += x[s] == y[s];
+        return same;
+    };
+
+    QVector<int> parent(n);
+    std::iota(parent.begin(), parent.end(), 0);
+    auto root = [&](int i) {
+        while (parent[i] != i) i = parent[i] = parent[parent[i]];
+        return i;
+    };
+
+    // One band at a time keeps the bucket table at n entries
+    const int needed = int(std::ceil(threshold * Slots));
+    qint64 comparisons = 0;
+    QHash<quint64, int> buckets;
+    buckets.reserve(n);
+    for (int band = 0; band < Bands; ++band) {
+        buckets.clear();
+        for (int i = 0; i < n; ++i) {
+            const quint32 *rows = out + i * Slots + band * Rows;
+            quint64 key = 1469598103934665603ULL;
+            for (int r = 0; r < Rows; ++r) key = mix(key ^ rows[r]);
+
+            auto it = buckets.constFind(key);
+            if (it == buckets.constEnd()) {
+                buckets.insert(key, i);
+                continue;
+            }
+            const int a = root(it.value());
+            const int b = root(i);
+            if (a == b) continue;
+            ++comparisons;
+            if (agreement(it.value(), i) >= needed) parent[qMax(a, b)] = qMin(a, b);
+        }
+    }
+
+    // Roots are the lowest index in each set, so clusters come out in library order
+    QVector<DuplicateCluster> clusters;
+    QHash<int, int> clusterOf;
+    for (int i = 0; i < n; ++i) {
+        const int r = root(i);
+        if (r == i) continue;
+
+        auto it = clusterOf.constFind(r);
+        int c = it != clusterOf.constEnd() ? it.value() : -1;
+        if (c < 0) {
+            c = clusters.size();
+            clusterOf.insert(r, c);
+            DuplicateCluster cluster;
+            cluster.cards.append(DuplicateCard{ cards[r].deckName, cards[r].id });
+            cluster.similarity = 1.0;
+            clusters.append(cluster);
+        }
+        clusters[c].cards.append(DuplicateCard{ cards[i].deckName, cards[i].id });
+        clusters[c].similarity = qMin(clusters[c].similarity, double(agreement(r, i)) / Slots);
+    }
+
+    if (stats) {
+        stats->cards = n;
+        stats->comparisons = comparisons;
+        stats->clusters = clusters.size();
+        stats->duplicates = 0;
+        for (const DuplicateCluster &c : clusters) stats->duplicates += c.cards.size() - 1;
+        stats->signMs = signMs;
+        stats->totalMs = timer.elapsed();
+    }
+    return clusters;
+}
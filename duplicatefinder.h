@@ -0,0 +1,65 @@
+#ifndef DUPLICATEFINDER_H
+#define DUPLICATEFINDER_H
+
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/*
+ * DuplicateFinder (near-duplicate cards across decks, MinHash + LSH)
+ *
+ *  - Each card's question and answer are case-folded, punctuation is dropped and
+ *    the text is cut into overlapping 4-character shingles.
+ *  - A 64-slot MinHash signature is computed per card on a thread pool. The
+ *    fraction of equal slots between two signatures estimates the Jaccard
+ *    similarity of their shingle sets.
+ *  - Signatures are split into 16 bands of 4 slots. Cards sharing a band land in
+ *    the same bucket; each card is only compared with the first card of each of
+ *    its buckets, so work grows with the number of cards, not its square.
+ *    Pairs at or above the threshold are joined into clusters (transitively).
+ *  - Identical text always clusters; pairs near the threshold may be missed,
+ *    which is the usual LSH trade-off.
+ */
+
+struct DuplicateCard
+{
+    QString deckName;
+    quint64 cardId = 0;
+};
+
+struct DuplicateCluster
+{
+    QVector<DuplicateCard> cards;   // in library order; the first is the one to keep
+    double similarity = 0.0;        // lowest estimated similarity to the first card
+};
+
+struct DuplicateScanStats
+{
+    qint64 cards = 0;
+    qint64 comparisons = 0;   // signature pairs compared
+    qint64 clusters = 0;
+    qint64 duplicates = 0;    // cards beyond the first in each cluster
+    qint64 signMs = 0;
+    qint64 totalMs = 0;
+};
+
+class DuplicateFinder
+{
+public:
+    struct Card
+    {
+        QString deckName;
+        quint64 id = 0;
+        QString question;
+        QString answer;
+    };
+
+    using Progress = std::function<bool(qint64 cardsSigned, qint64 totalCards)>;
+
+    // Empty (and stats->cards = 0) if cancelled through progress
+    static QVector<DuplicateCluster> find(const QVector<Card> &cards, double threshold = 0.8,
+                                          DuplicateScanStats *stats = nullptr,
+                                          const Progress &progress = Progress(), int maxThreads = 0);
+};
+
+#endif // DUPLICATEFINDER_H
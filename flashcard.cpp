@@ -1,16 +1,21 @@
 #include "flashcard.h"
 
-flashcard::flashcard(const QString &q, const QString &a)
-    : question(q), answer(a) {}
+flashcard::flashcard(const QString &q, const QString &a, quint64 id)
+    : question(q), answer(a), id(id) {}
 
 // Returns question
-QString flashcard::getQuestion() const { return question; }
+const QString &flashcard::getQuestion() const { return question; }
 
 // Returns answer
-QString flashcard::getAnswer() const { return answer; }
+const QString &flashcard::getAnswer() const { return answer; }
 
 // Set question to the given text
 void flashcard::setQuestion(const QString &q) { question = q; }
 
 // Set answer to the given text
 void flashcard::setAnswer(const QString &a) {answer = a;}
+
+// Returns the card's id (unique within its deck)
+quint64 flashcard::getId() const { return id; }
+
+void flashcard::setId(quint64 newId) { id = newId; }
@@ -8,13 +8,16 @@ class flashcard
 private:
     QString question;
     QString answer;
+    quint64 id = 0;   // 0 until the card is added to a deck
 
 public:
-    flashcard(const QString &q = "", const QString &a = "");
-    QString getQuestion() const;
-    QString getAnswer() const;
+    flashcard(const QString &q = "", const QString &a = "", quint64 id = 0);
+    const QString &getQuestion() const;
+    const QString &getAnswer() const;
     void setQuestion(const QString &q);
     void setAnswer(const QString &a);
+    quint64 getId() const;
+    void setId(quint64 newId);
 };
 
 #endif // FLASHCARD_H
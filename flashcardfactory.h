@@ -2,6 +2,7 @@
 #define FLASHCARDFACTORY_H
 
 #include "flashcard.h"
+#include <QRandomGenerator>
 #include <QString>
 #include <memory>
 
@@ -11,6 +12,8 @@
  * - Today your concrete data model is a single `flashcard` class (question/answer),
  *   so all creators currently return a `flashcard`. This still satisfies the pattern
  *   and lets you extend later (e.g., by evolving flashcard into a polymorphic hierarchy).
+ * - Every card the factory makes gets a fresh random 64-bit id (never 0), so ids stay
+ *   unique without any shared counter to persist.
  */
 
 enum class FlashcardType {
@@ -50,8 +53,21 @@ public:
 
 class FlashcardFactory {
 public:
+    static quint64 newId() {
+        quint64 id = 0;
+        while (id == 0) id = QRandomGenerator::global()->generate64();
+        return id;
+    }
+
     // Factory Method entry point
     static flashcard create(FlashcardType type, const QString& question, const QString& answer) {
+        flashcard card = createWithoutId(type, question, answer);
+        card.setId(newId());
+        return card;
+    }
+
+private:
+    static flashcard createWithoutId(FlashcardType type, const QString& question, const QString& answer) {
         switch (type) {
         case FlashcardType::Text: {
             static TextFlashcardCreator creator;
@@ -1,15 +1,64 @@
 #include "flashcardmanager.h"
 
 #include <QFile>
+#include <QCoreApplication>
+#include <QDateTime>
 #include <QDir>
+#include <QElapsedTimer>
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QJsonObject>
+#include <QMutexLocker>
+#include <QSet>
+#include <QSaveFile>
 #include <QStandardPaths>
+#include <QThread>
+#include <QThreadPool>
+#include "deckbundle.h"
+#include "instrumentation.h"
+#include "jsonstreamreader.h"
+#include "jsonstreamwriter.h"
+#include <algorithm>
+#include <atomic>
+#include <utility>
+
+// Card ids are written as decimal strings; JSON numbers are doubles and can't hold 64 bits
+static QString idToJson(quint64 id)
+{
+    return QString::number(id);
+}
+
+static quint64 idFromJson(const QJsonValue& v)
+{
+    return v.isString() ? v.toString().toULongLong() : quint64(v.toDouble());
+}
+
+static void scheduleToJson(const CardSchedule& s, QJsonObject& o)
+{
+    o["due"] = double(s.due);
+    o["interval"] = s.interval;
+    o["ease"] = s.ease;
+    o["repetitions"] = s.repetitions;
+    o["lapses"] = s.lapses;
+    o["reviews"] = s.reviews;
+}
+
+static CardSchedule scheduleFromJson(const QJsonObject& o)
+{
+    CardSchedule s;
+    s.due = qint64(o.value("due").toDouble());
+    s.interval = o.value("interval").toInt();
+    s.ease = ReviewScheduler::clampEase(o.value("ease").toInt(2500));
+    s.repetitions = quint16(o.value("repetitions").toInt());
+    s.lapses = quint16(o.value("lapses").toInt());
+    s.reviews = quint16(o.value("reviews").toInt());
+    return s;
+}
 
 static QJsonObject flashcardToJson(const flashcard& fc)
 {
     QJsonObject o;
+    o["id"] = idToJson(fc.getId());
     o["question"] = fc.getQuestion();
     o["answer"] = fc.getAnswer();
     return o;
@@ -17,7 +66,7 @@ static QJsonObject flashcardToJson(const flashcard& fc)
 
 static flashcard flashcardFromJson(const QJsonObject& o)
 {
-    return flashcard(o.value("question").toString(), o.value("answer").toString());
+    return flashcard(o.value("question").toString(), o.value("answer").toString(), idFromJson(o.value("id")));
 }
 
 static QJsonObject deckToJson(const deck& d)
@@ -27,28 +76,70 @@ static QJsonObject deckToJson(const deck& d)
     o["tag"]  = d.getTag();
 
     QJsonArray cards;
-    for (int i = 0; i < d.getSize(); ++i) {
-        cards.append(flashcardToJson(d.getCard(i)));
+    for (const flashcard& fc : d) {
+        cards.append(flashcardToJson(fc));
     }
     o["cards"] = cards;
     return o;
 }
 
-static deck deckFromJson(const QJsonObject& o)
+// Cards saved before ids existed get a fresh id from addCard(). That id is only stable
+// once written back out, so callers loading stored decks check freshIdsOut.
+static deck deckFromJson(const QJsonObject& o, bool *freshIdsOut = nullptr)
 {
     const QString name = o.value("name").toString();
     const QString tag  = o.value("tag").toString();
     deck d(name, tag);
 
     const QJsonArray cards = o.value("cards").toArray();
+    d.reserve(cards.size());
     for (const auto& v : cards) {
         if (!v.isObject()) continue;
-        d.addCard(flashcardFromJson(v.toObject()));
+        flashcard fc = flashcardFromJson(v.toObject());
+        if (fc.getId() == 0 && freshIdsOut) *freshIdsOut = true;
+        d.addCard(std::move(fc));
     }
     return d;
 }
 
+// Shards use the single-deck export layout plus the seq they are current up to,
+// so any shard can also be imported as a regular deck file.
+static bool writeShard(const QString& path, const deck& d, qint64 seq, QString *errorOut)
+{
+    QJsonObject root;
+    root["version"] = 1;
+    root["seq"] = double(seq);
+    root["deck"] = deckToJson(d);
+
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for writing.").arg(path);
+        return false;
+    }
+    f.write(QJsonDocument(root).toJson(QJsonDocument::Compact));
+    if (!f.commit()) {
+        if (errorOut) *errorOut = QString("Could not write %1.").arg(path);
+        return false;
+    }
+    return true;
+}
+
+static bool readShard(const QString& path, deck& out, qint64 *seqOut, bool *freshIdsOut)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) return false;
+
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+    if (!doc.isObject()) return false;
+
+    const QJsonObject root = doc.object();
+    out = deckFromJson(root.value("deck").toObject(), freshIdsOut);
+    if (seqOut) *seqOut = qint64(root.value("seq").toDouble());
+    return true;
+}
+
 flashcardManager::flashcardManager()
+    : m_persistence([this](QString *errorOut) { return writeSnapshotNow(errorOut); })
 {
     // Lazy load: do nothing here. instance() will call load once.
 }
@@ -64,191 +155,1995 @@ flashcardManager& flashcardManager::instance()
 }
 
 QString flashcardManager::storageFilePath() const
+{
+    return QDir(shardDirPath()).filePath("manifest.json");
+}
+
+QString flashcardManager::shardDirPath() const
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QDir(dir).filePath("decks");
+}
+
+QString flashcardManager::legacyStorageFilePath() const
 {
     const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     return QDir(dir).filePath("decks.json");
 }
 
-bool flashcardManager::saveToDisk(QString *errorOut) const
+QString flashcardManager::journalFilePath() const
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QDir(dir).filePath("decks.journal");
+}
+
+QString flashcardManager::scheduleFilePath() const
 {
-    const QString path = storageFilePath();
-    QDir().mkpath(QFileInfo(path).absolutePath());
+    return QDir(shardDirPath()).filePath("schedule.json");
+}
 
-    QJsonArray deckArr;
-    for (auto it = decks.constBegin(); it != decks.constEnd(); ++it) {
-        deckArr.append(deckToJson(it.value()));
+QString flashcardManager::reviewLogPath() const
+{
+    const QString dir = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    return QDir(dir).filePath("reviews.log");
+}
+
+void flashcardManager::setCompactionThreshold(qint64 bytes)
+{
+    m_compactThreshold = bytes;
+}
+
+void flashcardManager::setInterningEnabled(bool enabled)
+{
+    QMutexLocker lock(&m_mutex);
+    if (enabled == m_interning) return;
+    m_interning = enabled;
+    if (!enabled) {
+        m_strings.clear();
+        return;
     }
+    for (deck& d : decks) internDeck(d);   // decks loaded while it was off
+}
 
-    QJsonObject root;
-    root["version"] = 1;
-    root["decks"] = deckArr;
+bool flashcardManager::isInterningEnabled() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_interning;
+}
 
-    QFile f(path);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        if (errorOut) *errorOut = QString("Could not open %1 for writing.").arg(path);
-        return false;
+StringPool::Stats flashcardManager::internStats() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_strings.stats();
+}
+
+// Caller holds m_mutex
+void flashcardManager::internDeck(deck &d)
+{
+    if (m_interning) d.internText(m_strings);
+}
+
+flashcard flashcardManager::internCard(const flashcard &card)
+{
+    if (!m_interning) return card;
+    return flashcard(m_strings.intern(card.getQuestion()), m_strings.intern(card.getAnswer()), card.getId());
+}
+
+// Decks already loaded move to the layout the new threshold gives them
+void flashcardManager::setArenaThreshold(int cards)
+{
+    QMutexLocker lock(&m_mutex);
+    m_arenaThreshold = cards;
+    for (deck& d : decks) {
+        const deck::Storage s = cards > 0 && d.getSize() >= cards ? deck::Storage::Arena : deck::Storage::Vector;
+        if (s == d.storage()) continue;
+        d.setStorage(s);
+        if (s == deck::Storage::Vector) internDeck(d);
     }
-    f.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
-    return true;
 }
 
-bool flashcardManager::loadFromDisk(QString *errorOut)
+int flashcardManager::arenaThreshold() const
 {
-    const QString path = storageFilePath();
-    QFile f(path);
-    if (!f.exists()) {
-        // First run: nothing to load
-        return true;
+    QMutexLocker lock(&m_mutex);
+    return m_arenaThreshold;
+}
+
+PersistenceWorker::Stats flashcardManager::persistenceStats() const
+{
+    return m_persistence.stats();
+}
+
+// Takes a consistent snapshot under the lock, then writes it unlocked: only decks that
+// changed since their last write get a new shard, then the manifest is replaced.
+// Copying into a QVector (instead of sharing the QMap) keeps the deck* pointers handed
+// out by getDeck() valid: the live map never has to detach.
+bool flashcardManager::writeSnapshotNow(QString *errorOut)
+{
+    ScopedTimer timer("manager.save", "io");
+    QVector<deck> dirty;
+    QVector<DeckIndexEntry> manifest;
+    qint64 seq = 0;
+    QString rotated;
+    bool migrating = false;
+    ReviewScheduler schedule;
+    bool scheduleChanged = false;
+    bool sweep = false;
+    {
+        QMutexLocker lock(&m_mutex);
+        // A snapshot now would persist half of the open batch; commitBatch() asks again
+        if (m_batchDepth > 0) {
+            m_snapshotDeferred = true;
+            return true;
+        }
+        manifest.reserve(decks.size() + m_unloaded.size());
+        for (auto it = decks.begin(); it != decks.end(); ++it) {
+            DeckIndexEntry e;
+            e.name = it.key();
+            e.tag = it.value().getTag();
+            e.cardCount = it.value().getSize();
+            e.file = DeckIndex::shardFileName(it.key());
+            manifest.append(e);
+
+            if (it.value().isDirty()) dirty.append(it.value());
+        }
+        for (const DeckIndexEntry& e : m_unloaded) manifest.append(e);
+
+        // Implicitly shared: the copy costs nothing until the next review detaches it
+        scheduleChanged = m_scheduleDirty;
+        if (scheduleChanged) schedule = m_schedule;
+
+        // The journal is the only other copy of these edits, so nothing is marked
+        // clean until it has been moved aside
+        if (!m_journal.rotate(errorOut)) return false;
+        rotated = m_journal.rotatedPath();
+        for (const deck& d : std::as_const(dirty)) {
+            auto it = decks.find(d.getName());
+            if (it != decks.end()) it.value().setDirty(false);
+        }
+        m_scheduleDirty = false;
+
+        seq = m_seq;
+        migrating = m_migrationPending;
+        sweep = m_sweepShards;
+        m_strings.prune();   // drop text of cards that are gone
     }
-    if (!f.open(QIODevice::ReadOnly)) {
-        if (errorOut) *errorOut = QString("Could not open %1 for reading.").arg(path);
+
+    // On failure everything not yet on disk stays dirty for the next attempt; the
+    // rotated journal is kept, so a restart replays the same edits
+    auto restoreDirty = [&](int from, bool scheduleToo) {
+        QMutexLocker lock(&m_mutex);
+        for (int j = from; j < dirty.size(); ++j) {
+            auto it = decks.find(dirty[j].getName());
+            if (it != decks.end()) it.value().setDirty(true);
+        }
+        if (scheduleToo && scheduleChanged) m_scheduleDirty = true;
+    };
+
+    Instrumentation::instance().counter("manager.dirtyShards", dirty.size());
+    const QDir dir(shardDirPath());
+    QDir().mkpath(dir.absolutePath());
+
+    // Each shard is replaced atomically, so a crash here can't touch any other deck
+    for (int i = 0; i < dirty.size(); ++i) {
+        if (!writeShard(dir.filePath(DeckIndex::shardFileName(dirty[i].getName())), dirty[i], seq, errorOut)) {
+            restoreDirty(i, true);
+            return false;
+        }
+    }
+
+    if (scheduleChanged && !schedule.write(scheduleFilePath(), errorOut)) {
+        restoreDirty(0, true);
         return false;
     }
 
-    const QByteArray data = f.readAll();
-    const QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        if (errorOut) *errorOut = QString("Invalid JSON in %1.").arg(path);
+    // Until the manifest lands it still lists the old shards, so they are rewritten next time
+    if (!DeckIndex::write(storageFilePath(), seq, manifest, errorOut)) {
+        restoreDirty(0, true);
         return false;
     }
 
-    const QJsonObject root = doc.object();
-    const QJsonArray deckArr = root.value("decks").toArray();
+    // Everything in the rotated journal is now in the shards
+    QFile::remove(rotated);
+
+    // Drop shards of decks that are no longer in the manifest. Only done once this
+    // session has seen every shard on disk, so an unreadable one is never swept.
+    if (sweep) {
+        QSet<QString> live;
+        for (const DeckIndexEntry& e : manifest) live.insert(e.file);
+        live << "manifest.json" << "schedule.json";
+        const QStringList files = dir.entryList(QStringList() << "*.json", QDir::Files);
+        for (const QString& file : files) {
+            if (!live.contains(file)) QFile::remove(dir.filePath(file));
+        }
+    }
+
+    if (migrating) {
+        const QString legacy = legacyStorageFilePath();
+        QFile::remove(legacy + ".bak");
+        QFile::rename(legacy, legacy + ".bak");
+        QMutexLocker lock(&m_mutex);
+        m_migrationPending = false;
+    }
+    return true;
+}
+
+void flashcardManager::requestSave()
+{
+    m_persistence.markDirty();
+}
+
+bool flashcardManager::flush(QString *errorOut)
+{
+    QString logError;
+    const bool logged = m_reviewLog.flush(&logError);
+    if (!m_persistence.flush(errorOut)) return false;
+    if (!logged && errorOut) *errorOut = logError;
+    return logged;
+}
+
+bool flashcardManager::saveToDisk(QString *errorOut)
+{
+    requestSave();
+    return flush(errorOut);
+}
+
+bool flashcardManager::loadFromDisk(QString *errorOut)
+{
+    flush(nullptr);
+    ScopedTimer timer("manager.load", "io");
+
+    QMutexLocker lock(&m_mutex);
+    m_journal.setPath(journalFilePath());
+    m_reviewLog.setPath(reviewLogPath());
 
     // Replace current decks with loaded decks
     decks.clear();
+    m_unloaded.clear();
+    m_tagIndex.clear();
+    m_deckTagKeys.clear();
+    ++m_deckListVersion;
+    m_search.clear();
+    m_searchBuilt = false;
+    m_schedule.clear();
+    m_scheduleDirty = false;
+    m_scheduleStale.clear();
+    m_reviewStats.clear();
+    m_reviewStatsBuilt = false;
+    m_freshIdDecks.clear();
+    m_sweepShards = false;
+    if (QFile::exists(scheduleFilePath()) && !ReviewScheduler::read(scheduleFilePath(), m_schedule, errorOut)) {
+        return false;
+    }
+    qint64 snapshotSeq = 0;
 
-    for (const auto& v : deckArr) {
-        if (!v.isObject()) continue;
-        deck d = deckFromJson(v.toObject());
-        // Ensure key matches the deck name
-        decks.insert(d.getName(), d);
+    QVector<DeckIndexEntry> entries;
+    if (DeckIndex::read(storageFilePath(), &snapshotSeq, entries)) {
+        // Only the manifest is read here; shards are parsed when a deck is first requested
+        for (const DeckIndexEntry& e : entries) {
+            m_unloaded.insert(e.name, e);
+            indexDeckTags(e.name, e.tag);
+        }
+        // A deck listed under another deck's file (renamed on disk by an older build) is
+        // loaded now, so nothing written under that file name can clobber it
+        for (const DeckIndexEntry& e : entries) {
+            if (e.file != DeckIndex::shardFileName(e.name)) loadShard(e.name, nullptr);
+        }
+        m_sweepShards = true;
+    } else if (QFile::exists(legacyStorageFilePath())) {
+        // Monolithic decks.json from before the sharded layout: load it fully once,
+        // then let the persistence thread split it into shards.
+        const QString path = legacyStorageFilePath();
+        QFile f(path);
+        if (!f.open(QIODevice::ReadOnly)) {
+            if (errorOut) *errorOut = QString("Could not open %1 for reading.").arg(path);
+            return false;
+        }
+
+        const QByteArray data = f.readAll();
+        const QJsonDocument doc = QJsonDocument::fromJson(data);
+        if (!doc.isObject()) {
+            if (errorOut) *errorOut = QString("Invalid JSON in %1.").arg(path);
+            return false;
+        }
+
+        const QJsonObject root = doc.object();
+        const QJsonArray deckArr = root.value("decks").toArray();
+        snapshotSeq = qint64(root.value("seq").toDouble());
+
+        for (const auto& v : deckArr) {
+            if (!v.isObject()) continue;
+            bool freshIds = false;
+            deck d = deckFromJson(v.toObject(), &freshIds);
+            if (freshIds) m_freshIdDecks.insert(d.getName());
+            internDeck(d);
+            indexDeckTags(d.getName(), d.getTag());
+            // Ensure key matches the deck name
+            decks.insert(d.getName(), d);
+        }
+
+        m_migrationPending = true;
+        m_sweepShards = true;
+        m_persistence.markDirty();
+    } else {
+        // No readable manifest: list whatever shards are on disk instead of starting
+        // empty, and write a new manifest for them
+        m_sweepShards = rebuildIndexFromShards();
+        if (!m_unloaded.isEmpty()) m_persistence.markDirty();
+    }
+
+    // Replay journaled changes made after the manifest. A crash between writing shards
+    // and the manifest can leave shards that already contain some of these records,
+    // so each deck also skips records older than its own shard.
+    m_seq = snapshotSeq;
+    QHash<QString, qint64> deckSeq;
+    const QVector<QJsonObject> records = m_journal.readAll();
+    for (const QJsonObject& r : records) {
+        const qint64 seq = qint64(r.value("seq").toDouble());
+        if (seq <= m_seq) continue;
+        applyRecord(r, deckSeq);
+        m_seq = seq;
+    }
+
+    // schedule.json only has reviewed cards; a deck holding more has new ones to add,
+    // which nextDueCard() does when it first needs the deck
+    for (auto it = decks.constBegin(); it != decks.constEnd(); ++it) {
+        if (it.value().getSize() != m_schedule.cardCount(it.key())) m_scheduleStale.insert(it.key());
+    }
+    for (auto it = m_unloaded.constBegin(); it != m_unloaded.constEnd(); ++it) {
+        if (it.value().cardCount != m_schedule.cardCount(it.key())) m_scheduleStale.insert(it.key());
+    }
+
+    // Fresh ids of cards that were only read from decks.json or an old journal record are
+    // journaled, so a reload before the next snapshot gets the same ones back
+    for (const QString& name : std::as_const(m_freshIdDecks)) {
+        auto it = decks.constFind(name);
+        if (it == decks.constEnd()) continue;
+        QJsonObject r;
+        r["op"] = "addDeck";
+        r["deck"] = deckToJson(it.value());
+        journal(r);
     }
+    m_freshIdDecks.clear();
     return true;
 }
 
-void flashcardManager::addDeck(const deck &d)
+// Lists every readable shard under decks/ in m_unloaded. Returns false if some
+// shard could not be read. Caller must hold m_mutex.
+bool flashcardManager::rebuildIndexFromShards()
 {
-    // Ensure loaded
-    (void)instance();
+    const QDir dir(shardDirPath());
+    const QStringList files = dir.entryList(QStringList() << "*.json", QDir::Files);
+    QHash<QString, qint64> newest;
+    bool allRead = true;
+    for (const QString& file : files) {
+        if (file == "manifest.json" || file == "schedule.json") continue;
+        deck d;
+        qint64 shardSeq = 0;
+        if (!readShard(dir.filePath(file), d, &shardSeq, nullptr) || d.getName().isEmpty()) {
+            allRead = false;
+            continue;
+        }
+        // A renamed deck can leave its old shard behind; the newer one wins
+        if (newest.contains(d.getName()) && newest.value(d.getName()) >= shardSeq) continue;
+        newest.insert(d.getName(), shardSeq);
 
-    decks[d.getName()] = d;
-    if (!m_suppressAutosave) saveToDisk(nullptr);
+        DeckIndexEntry e;
+        e.name = d.getName();
+        e.tag = d.getTag();
+        e.cardCount = d.getSize();
+        e.file = file;
+        m_unloaded.insert(e.name, e);
+    }
+    const QList<DeckIndexEntry> entries = m_unloaded.values();
+    for (const DeckIndexEntry& e : entries) {
+        indexDeckTags(e.name, e.tag);
+        if (e.file != DeckIndex::shardFileName(e.name)) loadShard(e.name, nullptr);
+    }
+    return allRead;
 }
 
-deck* flashcardManager::getDeck(const QString &name)
+// Applies one journal record to the in-memory decks (used by replay).
+// deckSeq tracks, per deck, the newest seq its in-memory state already includes.
+bool flashcardManager::applyRecord(const QJsonObject &record, QHash<QString, qint64> &deckSeq)
 {
-    (void)instance();
+    const QString op = record.value("op").toString();
+    if (op == "batch") {
+        bool applied = false;
+        const QJsonArray records = record.value("records").toArray();
+        for (const QJsonValue& v : records) applied = applyRecord(v.toObject(), deckSeq) || applied;
+        return applied;
+    }
+    if (op == "review") {
+        // Schedules aren't in the shards, so there is no shard seq to compare; setting one is idempotent
+        m_schedule.set(record.value("name").toString(), idFromJson(record.value("id")), scheduleFromJson(record));
+        m_scheduleDirty = true;
+        return true;
+    }
+
+    const qint64 seq = qint64(record.value("seq").toDouble());
+    const QString name = op == "addDeck"
+        ? record.value("deck").toObject().value("name").toString()
+        : record.value("name").toString();
+
+    if (!decks.contains(name)) {
+        // Probe the shard even if the manifest doesn't list it yet
+        qint64 shardSeq = 0;
+        if (loadShard(name, &shardSeq)) deckSeq[name] = shardSeq;
+    }
+    if (deckSeq.value(name, 0) >= seq) return false;
+    deckSeq[name] = seq;
+
+    if (op == "addDeck") {
+        bool freshIds = false;
+        deck d = deckFromJson(record.value("deck").toObject(), &freshIds);
+        if (freshIds) m_freshIdDecks.insert(name);
+        else m_freshIdDecks.remove(name);
+        internDeck(d);
+        indexDeckTags(name, d.getTag());
+        m_unloaded.remove(name);
+        decks[name] = d;
+        return true;
+    }
+
+    if (op == "removeDeck") {
+        unindexDeck(name);
+        m_schedule.removeDeck(name);
+        m_scheduleDirty = true;
+        return (decks.remove(name) + m_unloaded.remove(name)) > 0;
+    }
+
+    if (op == "renameDeck") {
+        const QString to = record.value("to").toString();
+        if (!renameDeckLocked(name, to)) return false;
+        deckSeq[to] = seq;
+        return true;
+    }
 
     auto it = decks.find(name);
-    if (it == decks.end()) return nullptr;
-    return &it.value();
+    if (it == decks.end()) return false;
+    deck *d = &it.value();
+
+    // Card records address cards by id; records from before ids existed carry an index
+    if (op == "addCard") {
+        flashcard fc = flashcardFromJson(record.value("card").toObject());
+        if (fc.getId() == 0) fc.setId(quint64(seq));   // deterministic across replays
+        d->addCard(internCard(fc));
+        return true;
+    }
+    if (op == "updateCard") {
+        const flashcard fc = internCard(flashcardFromJson(record.value("card").toObject()));
+        if (record.contains("id")) return d->updateCardById(idFromJson(record.value("id")), fc);
+        return d->updateCard(record.value("index").toInt(), fc);
+    }
+    if (op == "removeCard") {
+        if (record.contains("id")) {
+            const quint64 id = idFromJson(record.value("id"));
+            m_schedule.removeCard(name, id);
+            m_scheduleDirty = true;
+            return d->removeCardById(id);
+        }
+        return d->removeCard(record.value("index").toInt());
+    }
+    if (op == "setTag") {
+        d->setTag(record.value("tag").toString());
+        indexDeckTags(name, d->getTag());
+        return true;
+    }
+    if (op == "applyPatch") {
+        DeckPatch patch;
+        if (!DeckPatch::fromJson(record.value("patch").toObject(), patch) || !patch.check(*d)) return false;
+        patch.apply(*d);
+        if (patch.tagChanged) indexDeckTags(name, d->getTag());
+        for (const DeckPatchRecord& pr : patch.records) {
+            if (pr.op == DeckPatchRecord::Delete) m_schedule.removeCard(name, pr.id);
+        }
+        m_scheduleDirty = true;
+        return true;
+    }
+    return false;
 }
 
-bool flashcardManager::removeDeck(const QString &name)
+// Parses a deck's shard into the live map. Caller must hold m_mutex.
+deck* flashcardManager::loadShard(const QString &name, qint64 *seqOut)
 {
-    (void)instance();
+    ScopedTimer timer("manager.loadShard", "io");
+    auto u = m_unloaded.constFind(name);
+    const QString file = u != m_unloaded.constEnd() ? u->file : DeckIndex::shardFileName(name);
 
-    const int removed = decks.remove(name);
-    if (removed > 0 && !m_suppressAutosave) saveToDisk(nullptr);
-    return removed > 0;
+    const QString path = QDir(shardDirPath()).filePath(file);
+    deck d;
+    qint64 shardSeq = 0;
+    bool freshIds = false;
+    if (!readShard(path, d, &shardSeq, &freshIds)) return nullptr;
+    if (seqOut) *seqOut = shardSeq;
+    // Ids given to cards from before ids existed are written back before anything can refer to them
+    const bool idsSaved = !freshIds || writeShard(path, d, shardSeq, nullptr);
+
+    d.setName(name);
+    if (m_arenaThreshold > 0 && d.getSize() >= m_arenaThreshold) d.setStorage(deck::Storage::Arena);
+    internDeck(d);
+    indexDeckTags(name, d.getTag());
+    d.setDirty(!idsSaved || file != DeckIndex::shardFileName(name));   // listed under another file: rewrite under its own
+    m_unloaded.remove(name);
+    return &decks.insert(name, d).value();
 }
 
-QStringList flashcardManager::getDeckNames() const
+// Looks a deck up, loading its shard on first use. Caller must hold m_mutex.
+deck* flashcardManager::findDeck(const QString &name)
 {
-    // Note: const function cannot call instance() safely without const_cast.
-    // In practice, MainWindow calls instance() early.
-    return decks.keys();
+    auto it = decks.find(name);
+    if (it != decks.end()) return &it.value();
+
+    if (!m_unloaded.contains(name)) return nullptr;
+    return loadShard(name, nullptr);
 }
 
-static QString uniqueNameForImport(const QMap<QString, deck>& decks, QString base)
+static QJsonObject batchRecord(const QVector<QJsonObject>& records, qint64 seq)
 {
-    if (!decks.contains(base)) return base;
-    int i = 2;
-    while (decks.contains(QString("%1 (%2)").arg(base).arg(i))) ++i;
-    return QString("%1 (%2)").arg(base).arg(i);
+    QJsonArray arr;
+    for (const QJsonObject& r : records) arr.append(r);
+
+    QJsonObject batch;
+    batch["op"] = "batch";
+    batch["seq"] = double(seq);
+    batch["records"] = arr;
+    return batch;
 }
 
-bool flashcardManager::exportDeckToFile(const QString& deckName, const QString& filePath, QString *errorOut) const
+// Appends a mutation to the journal (or to the open batch) and compacts once it gets large
+void flashcardManager::journal(QJsonObject record)
 {
-    auto it = decks.constFind(deckName);
-    if (it == decks.constEnd()) {
-        if (errorOut) *errorOut = "Deck not found.";
-        return false;
+    record["seq"] = double(++m_seq);
+    if (m_suppressAutosave) {
+        m_batchRecords.append(record);   // written as one line by commitBatch()
+        return;
     }
+    appendToJournal(record);
+}
 
-    QFile f(filePath);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        if (errorOut) *errorOut = "Could not open file for writing.";
-        return false;
+void flashcardManager::appendToJournal(const QJsonObject &record)
+{
+    // Journal unusable: fall back to a full snapshot. Otherwise compact once it gets large.
+    if (!m_journal.append(record) || m_journal.size() >= m_compactThreshold) {
+        m_persistence.markDirty();
     }
+}
 
-    QJsonObject root;
-    root["version"] = 1;
-    root["deck"] = deckToJson(it.value());
+// Journals records as one line, so replay applies all of them or none (or adds them to the
+// open batch). Caller holds m_mutex.
+void flashcardManager::journalBatch(QVector<QJsonObject> records)
+{
+    if (records.isEmpty()) return;
+    for (QJsonObject& r : records) r["seq"] = double(++m_seq);
+    if (m_suppressAutosave) {
+        m_batchRecords += records;
+        return;
+    }
+    appendToJournal(batchRecord(records, m_seq));
+}
 
-    f.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
-    return true;
+void flashcardManager::beginBatch()
+{
+    (void)instance();
+    Q_ASSERT_X(!QCoreApplication::instance() || QThread::currentThread() == QCoreApplication::instance()->thread(),
+               "flashcardManager::beginBatch", "batches are GUI-thread only");
+
+    QMutexLocker lock(&m_mutex);
+    ++m_batchDepth;
+    m_suppressAutosave = true;
 }
 
-bool flashcardManager::exportAllDecksToFile(const QString& filePath, QString *errorOut) const
+void flashcardManager::commitBatch()
 {
-    QFile f(filePath);
-    if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
-        if (errorOut) *errorOut = "Could not open file for writing.";
-        return false;
+    Q_ASSERT_X(!QCoreApplication::instance() || QThread::currentThread() == QCoreApplication::instance()->thread(),
+               "flashcardManager::commitBatch", "batches are GUI-thread only");
+
+    QMutexLocker lock(&m_mutex);
+    if (m_batchDepth == 0 || --m_batchDepth > 0) return;
+    m_suppressAutosave = false;
+
+    if (!m_batchRecords.isEmpty()) {
+        appendToJournal(batchRecord(m_batchRecords, m_seq));
+        m_batchRecords.clear();
+    }
+    if (m_snapshotDeferred) {
+        m_snapshotDeferred = false;
+        m_persistence.markDirty();
     }
+}
 
-    QJsonArray deckArr;
-    for (auto it = decks.constBegin(); it != decks.constEnd(); ++it) {
-        deckArr.append(deckToJson(it.value()));
+void flashcardManager::addDeck(const deck &d)
+{
+    // Ensure loaded
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    m_unloaded.remove(d.getName());
+    deck &stored = decks[d.getName()] = d;
+    internDeck(stored);
+    indexDeckTags(d.getName(), d.getTag());
+    m_scheduleStale.insert(d.getName());
+    if (m_searchBuilt) {
+        m_search.removeDeck(d.getName());
+        indexCards(stored);
     }
 
-    QJsonObject root;
-    root["version"] = 1;
-    root["decks"] = deckArr;
+    QJsonObject r;
+    r["op"] = "addDeck";
+    r["deck"] = deckToJson(d);
+    journal(r);
+}
 
-    f.write(QJsonDocument(root).toJson(QJsonDocument::Indented));
-    return true;
+deck* flashcardManager::getDeck(const QString &name)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    return findDeck(name);
 }
 
-bool flashcardManager::importDeckFromFile(const QString& filePath, QString *importedNameOut, QString *errorOut)
+// Review log marker that lets later readers follow a deck's reviews to its current name
+static ReviewRecord deckChangeRecord(ReviewRecord::Kind kind, const QString &name, const QString &to = QString())
+{
+    ReviewRecord r;
+    r.kind = kind;
+    r.deckKey = ReviewRecord::keyOf(name);
+    if (kind == ReviewRecord::RenameDeck) r.cardId = ReviewRecord::keyOf(to);
+    r.timestamp = QDateTime::currentMSecsSinceEpoch();
+    return r;
+}
+
+bool flashcardManager::removeDeck(const QString &name)
 {
     (void)instance();
 
-    QFile f(filePath);
-    if (!f.open(QIODevice::ReadOnly)) {
-        if (errorOut) *errorOut = "Could not open file for reading.";
-        return false;
+    QMutexLocker lock(&m_mutex);
+    const int removed = decks.remove(name) + m_unloaded.remove(name);
+    if (removed > 0) {
+        unindexDeck(name);
+        if (m_searchBuilt) m_search.removeDeck(name);
+        m_schedule.removeDeck(name);
+        m_scheduleDirty = true;
+        m_scheduleStale.remove(name);
+        m_reviewStats.removeDeck(name);
+        m_reviewLog.append(deckChangeRecord(ReviewRecord::RemoveDeck, name));
+        QJsonObject r;
+        r["op"] = "removeDeck";
+        r["name"] = name;
+        journal(r);
     }
+    return removed > 0;
+}
 
-    const QByteArray data = f.readAll();
-    const QJsonDocument doc = QJsonDocument::fromJson(data);
-    if (!doc.isObject()) {
-        if (errorOut) *errorOut = "Invalid JSON file.";
+bool flashcardManager::renameDeck(const QString &oldName, const QString &newName, QString *errorOut)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    if (oldName == newName) return true;
+    if (decks.contains(newName) || m_unloaded.contains(newName)) {
+        if (errorOut) *errorOut = QString("A deck named %1 already exists.").arg(newName);
+        return false;
+    }
+    if (!renameDeckLocked(oldName, newName)) {
+        if (errorOut) *errorOut = "Deck not found.";
         return false;
     }
+    m_reviewLog.append(deckChangeRecord(ReviewRecord::RenameDeck, oldName, newName));
 
-    const QJsonObject root = doc.object();
+    QJsonObject r;
+    r["op"] = "renameDeck";
+    r["name"] = oldName;
+    r["to"] = newName;
+    journal(r);
+    return true;
+}
+
+// Re-keys a deck without touching its cards. Caller holds m_mutex and has checked
+// that newName is free.
+bool flashcardManager::renameDeckLocked(const QString &oldName, const QString &newName)
+{
+    if (newName.isEmpty() || decks.contains(newName) || m_unloaded.contains(newName)) return false;
 
-    // Accept either {"deck": {...}} or a raw deck object
-    QJsonObject deckObj;
-    if (root.contains("deck") && root.value("deck").isObject()) {
-        deckObj = root.value("deck").toObject();
+    QString tag;
+    auto it = decks.find(oldName);
+    if (it != decks.end()) {
+        // Cards are implicitly shared, so moving the deck is O(1). The shard is rewritten
+        // under the new name at the next snapshot; the old one is dropped then.
+        deck moved = std::move(it.value());
+        decks.erase(it);
+        moved.setName(newName);
+        tag = moved.getTag();
+        decks.insert(newName, std::move(moved));
     } else {
-        deckObj = root;
+        auto u = m_unloaded.find(oldName);
+        if (u == m_unloaded.end()) return false;
+        // Still on disk: give the deck its own copy of the shard under the new name, so a
+        // later deck called oldName can't overwrite it. The old file stays valid for the
+        // manifest on disk until the next snapshot drops it.
+        const QDir dir(shardDirPath());
+        const QString file = DeckIndex::shardFileName(newName);
+        if (u->file != file) {
+            QFile::remove(dir.filePath(file));
+            if (!QFile::copy(dir.filePath(u->file), dir.filePath(file))) {
+                // Couldn't copy: load it, and the next snapshot writes it under the new name
+                if (!loadShard(oldName, nullptr)) return false;
+                return renameDeckLocked(oldName, newName);
+            }
+        }
+        DeckIndexEntry e = u.value();
+        m_unloaded.erase(u);
+        e.name = newName;
+        e.file = file;
+        tag = e.tag;
+        m_unloaded.insert(newName, e);
     }
 
-    deck d = deckFromJson(deckObj);
-    QString name = d.getName().trimmed();
-    if (name.isEmpty()) name = "Imported Deck";
+    if (m_freshIdDecks.remove(oldName)) m_freshIdDecks.insert(newName);
+    if (m_scheduleStale.remove(oldName)) m_scheduleStale.insert(newName);
+    unindexDeck(oldName);
+    indexDeckTags(newName, tag);
+    if (m_searchBuilt) m_search.renameDeck(oldName, newName);
+    m_schedule.renameDeck(oldName, newName);
+    m_scheduleDirty = true;
+    m_reviewStats.renameDeck(oldName, newName);
+    return true;
+}
 
-    name = uniqueNameForImport(decks, name);
-    d.setName(name);
+QStringList flashcardManager::getDeckNames() const
+{
+    // Note: const function cannot call instance() safely without const_cast.
+    // In practice, MainWindow calls instance() early.
+    QMutexLocker lock(&m_mutex);
+    if (m_unloaded.isEmpty()) return decks.keys();
 
-    // addDeck will autosave
-    addDeck(d);
+    QStringList names = decks.keys() + m_unloaded.keys();
+    std::sort(names.begin(), names.end());
+    return names;
+}
 
-    if (importedNameOut) *importedNameOut = name;
-    return true;
+QString flashcardManager::getDeckTag(const QString &name) const
+{
+    QMutexLocker lock(&m_mutex);
+    auto it = decks.constFind(name);
+    if (it != decks.constEnd()) return it.value().getTag();
+    return m_unloaded.value(name).tag;
+}
+
+bool flashcardManager::hasDeck(const QString &name) const
+{
+    QMutexLocker lock(&m_mutex);
+    return decks.contains(name) || m_unloaded.contains(name);
+}
+
+QStringList flashcardManager::findDecksByTags(const QString &query, QString *errorOut) const
+{
+    const TagQuery q = TagQuery::parse(query, errorOut);
+    if (!q.isValid()) return QStringList();
+
+    QMutexLocker lock(&m_mutex);
+    const QSet<QString> matched = q.evaluate(
+        [this](const QString &key) -> const QSet<QString> * {
+            auto it = m_tagIndex.constFind(key);
+            return it != m_tagIndex.constEnd() ? &it.value() : nullptr;
+        },
+        [this]() {
+            QSet<QString> all;
+            all.reserve(decks.size() + m_unloaded.size());
+            for (auto it = decks.constBegin(); it != decks.constEnd(); ++it) all.insert(it.key());
+            for (auto it = m_unloaded.constBegin(); it != m_unloaded.constEnd(); ++it) all.insert(it.key());
+            return all;
+        });
+
+    QStringList names(matched.constBegin(), matched.constEnd());
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+QStringList flashcardManager::getAllTags() const
+{
+    QMutexLocker lock(&m_mutex);
+    QStringList keys = m_tagIndex.keys();
+    std::sort(keys.begin(), keys.end());
+    return keys;
+}
+
+quint64 flashcardManager::deckListVersion() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_deckListVersion;
+}
+
+QVector<SearchHit> flashcardManager::searchCards(const QString &query, SearchIndex::Match mode, int limit)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    if (!m_searchBuilt) {
+        // First search: every deck has to be in memory to be indexed
+        ScopedTimer buildTimer("search.build", "search");
+        const QStringList names = m_unloaded.keys();
+        for (const QString& name : names) findDeck(name);
+        for (const deck& d : std::as_const(decks)) indexCards(d);
+        m_searchBuilt = true;
+    }
+    ScopedTimer timer("search.query", "search");
+    const QVector<SearchHit> hits = m_search.search(query, mode, limit);
+    Instrumentation::instance().counter("search.hits", hits.size(), "search");
+    return hits;
+}
+
+QVector<DuplicateCluster> flashcardManager::findDuplicateCards(double threshold, DuplicateScanStats *stats,
+                                                              const ProgressCallback& progress)
+{
+    (void)instance();
+
+    QVector<DuplicateFinder::Card> cards;
+    {
+        QMutexLocker lock(&m_mutex);
+        const QStringList names = m_unloaded.keys();
+        for (const QString& name : names) findDeck(name);
+
+        qint64 total = 0;
+        for (const deck& d : std::as_const(decks)) total += d.getSize();
+        cards.reserve(int(total));
+        for (const deck& d : std::as_const(decks)) {
+            for (const flashcard& fc : d) {
+                DuplicateFinder::Card c;
+                c.deckName = d.getName();
+                c.id = fc.getId();
+                c.question = fc.getQuestion();
+                c.answer = fc.getAnswer();
+                cards.append(c);
+            }
+        }
+    }
+    return DuplicateFinder::find(cards, threshold, stats, progress);
+}
+
+int flashcardManager::removeDuplicateCards(const QVector<DuplicateCluster>& clusters, bool removeEmptyDecks)
+{
+    (void)instance();
+
+    Batch batch(*this);   // one journal record and one save for the whole cleanup
+    int removed = 0;
+    QSet<QString> touched;
+    for (const DuplicateCluster& c : clusters) {
+        for (int i = 1; i < c.cards.size(); ++i) {
+            if (!removeCardById(c.cards[i].deckName, c.cards[i].cardId)) continue;
+            ++removed;
+            touched.insert(c.cards[i].deckName);
+        }
+    }
+
+    if (removeEmptyDecks) {
+        for (const QString& name : std::as_const(touched)) {
+            const deck *d = getDeck(name);
+            if (d && d->getSize() == 0) removeDeck(name);
+        }
+    }
+    return removed;
+}
+
+DueCard flashcardManager::nextDueCard(const QString &deckName)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    if (!deckName.isEmpty()) {
+        const deck *d = findDeck(deckName);
+        if (!d) return DueCard();
+        syncSchedule(deckName, *d);
+    }
+
+    const qint64 now = QDateTime::currentSecsSinceEpoch();
+    for (;;) {
+        const DueCard c = m_schedule.next(deckName);
+        // A stale deck's new cards would be due now: sync one such deck and look again
+        if (deckName.isEmpty() && !m_scheduleStale.isEmpty() && (c.cardId == 0 || c.due > now)) {
+            const QString name = *m_scheduleStale.constBegin();
+            if (const deck *d = findDeck(name)) syncSchedule(name, *d);
+            else m_scheduleStale.remove(name);
+            continue;
+        }
+        if (c.cardId == 0) return c;
+
+        const deck *d = findDeck(c.deckName);
+        if (!d) {
+            m_schedule.removeDeck(c.deckName);   // gone since schedule.json was written
+        } else if (m_scheduleStale.contains(c.deckName)) {
+            syncSchedule(c.deckName, *d);
+            continue;
+        } else if (d->contains(c.cardId)) {
+            return c;
+        } else {
+            m_schedule.removeCard(c.deckName, c.cardId);   // removed without going through the manager
+        }
+        m_scheduleDirty = true;
+    }
+}
+
+CardSchedule flashcardManager::cardSchedule(const QString &deckName, quint64 id) const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_schedule.schedule(deckName, id);
+}
+
+bool flashcardManager::reviewCard(const QString &deckName, quint64 id, int quality)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    const deck *d = findDeck(deckName);
+    if (!d || !d->contains(id)) return false;
+
+    const CardSchedule s = ReviewScheduler::review(m_schedule.schedule(deckName, id), quality,
+                                                   QDateTime::currentSecsSinceEpoch());
+    m_schedule.set(deckName, id, s);
+    m_scheduleDirty = true;
+
+    QJsonObject r;
+    r["op"] = "review";
+    r["name"] = deckName;
+    r["id"] = idToJson(id);
+    scheduleToJson(s, r);
+    journal(r);
+    return true;
+}
+
+void flashcardManager::logReview(const QString &deckName, quint64 cardId, int grade, quint32 latencyMs)
+{
+    (void)instance();
+
+    ReviewRecord r;
+    r.cardId = cardId;
+    r.deckKey = ReviewRecord::keyOf(deckName);
+    r.timestamp = QDateTime::currentMSecsSinceEpoch();
+    r.latencyMs = latencyMs;
+    r.grade = quint8(qBound(0, grade, 5));
+
+    // Under the lock so a concurrent rebuild sees the record either in the log or not at all
+    QMutexLocker lock(&m_mutex);
+    m_reviewLog.append(r);
+    if (m_reviewStatsBuilt) m_reviewStats.add(deckName, m_deckTagKeys.value(deckName), r);
+}
+
+// Maps each record of the log to the key of the deck that holds it now: walking backwards,
+// a rename passes the new name's fate on to the old key, a removal drops the key's earlier
+// reviews. Markers, reviews of removed decks and version 1 records map to 0.
+static QVector<quint64> currentDeckKeys(const ReviewLogReader& reader)
+{
+    QVector<quint64> keys(int(reader.count()), 0);
+    QHash<quint64, quint64> fate;   // absent: the key is still current
+    for (qint64 i = reader.count() - 1; i >= 0; --i) {
+        const ReviewRecord& r = reader.at(i);
+        if (r.kind == ReviewRecord::RenameDeck) fate.insert(r.deckKey, fate.value(r.cardId, r.cardId));
+        else if (r.kind == ReviewRecord::RemoveDeck) fate.insert(r.deckKey, 0);
+        else if (r.deckKey != 0) keys[int(i)] = fate.value(r.deckKey, r.deckKey);
+    }
+    return keys;
+}
+
+ReviewStats flashcardManager::reviewStats(QString *errorOut)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    if (m_reviewStatsBuilt) return m_reviewStats;
+
+    ReviewLogReader reader;
+    if (!m_reviewLog.flush(errorOut) || !reader.open(reviewLogPath(), errorOut)) return ReviewStats();
+
+    QHash<quint64, QString> nameOf;
+    for (auto it = decks.constBegin(); it != decks.constEnd(); ++it) nameOf.insert(ReviewRecord::keyOf(it.key()), it.key());
+    for (auto it = m_unloaded.constBegin(); it != m_unloaded.constEnd(); ++it) nameOf.insert(ReviewRecord::keyOf(it.key()), it.key());
+
+    // Version 1 records carry no deck; credit those to the deck holding the card now
+    // (the first by name if copies share ids). This loads every deck, once.
+    QHash<quint64, QString> legacyDeckOf;
+    bool legacyMapped = false;
+    auto legacyDeck = [&](quint64 id) {
+        if (!legacyMapped) {
+            legacyMapped = true;
+            QStringList names = nameOf.values();
+            std::sort(names.begin(), names.end());
+            for (const QString& name : std::as_const(names)) {
+                const deck *d = findDeck(name);
+                if (!d) continue;
+                for (quint64 cardId : d->cardIds()) {
+                    if (!legacyDeckOf.contains(cardId)) legacyDeckOf.insert(cardId, name);
+                }
+            }
+        }
+        return legacyDeckOf.value(id);
+    };
+
+    const QVector<quint64> keys = currentDeckKeys(reader);
+    m_reviewStats.clear();
+    for (qint64 i = 0; i < reader.count(); ++i) {
+        const ReviewRecord& r = reader.at(i);
+        if (r.kind != ReviewRecord::Review) continue;
+        const QString name = r.deckKey != 0 ? nameOf.value(keys[int(i)]) : legacyDeck(r.cardId);
+        if (!name.isEmpty()) m_reviewStats.add(name, m_deckTagKeys.value(name), r);
+    }
+    m_reviewStatsBuilt = true;
+    return m_reviewStats;
+}
+
+QVector<ReviewRecord> flashcardManager::reviewHistory(const QString &deckName, quint64 cardId, QString *errorOut)
+{
+    (void)instance();
+
+    QVector<ReviewRecord> history;
+    ReviewLogReader reader;
+    if (!m_reviewLog.flush(errorOut) || !reader.open(reviewLogPath(), errorOut)) return history;
+
+    // Version 1 records can't be told apart by deck, so they match by id alone
+    const quint64 key = ReviewRecord::keyOf(deckName);
+    const QVector<quint64> keys = currentDeckKeys(reader);
+    for (qint64 i = 0; i < reader.count(); ++i) {
+        const ReviewRecord& r = reader.at(i);
+        if (r.kind == ReviewRecord::Review && r.cardId == cardId && (r.deckKey == 0 || keys[int(i)] == key)) {
+            history.append(r);
+        }
+    }
+    return history;
+}
+
+// Brings a deck's schedule in line with its cards when the counts disagree (cards added
+// anywhere, or the first look at the deck since loading). Caller holds m_mutex.
+void flashcardManager::syncSchedule(const QString &name, const deck &d)
+{
+    m_scheduleStale.remove(name);
+    if (m_schedule.cardCount(name) == d.getSize()) return;
+    m_schedule.syncDeck(name, d.cardIds(), QDateTime::currentSecsSinceEpoch());
+    m_scheduleDirty = true;
+}
+
+// Caller holds m_mutex
+void flashcardManager::indexCards(const deck &d)
+{
+    for (const flashcard& fc : d) m_search.addCard(d.getName(), fc.getId(), fc.getQuestion(), fc.getAnswer());
+}
+
+// Points the tag index at a deck's current tags. Caller holds m_mutex.
+void flashcardManager::indexDeckTags(const QString &name, const QString &tag)
+{
+    QStringList keys;
+    for (const QString& t : deck::splitTags(tag)) keys.append(TagQuery::key(t));
+    auto it = m_deckTagKeys.constFind(name);
+    if (it != m_deckTagKeys.constEnd() && it.value() == keys) return;
+
+    unindexDeck(name);
+    for (const QString& key : keys) m_tagIndex[key].insert(name);
+    m_deckTagKeys.insert(name, keys);
+}
+
+void flashcardManager::unindexDeck(const QString &name)
+{
+    ++m_deckListVersion;
+    const QStringList keys = m_deckTagKeys.take(name);
+    for (const QString& key : keys) {
+        auto it = m_tagIndex.find(key);
+        if (it == m_tagIndex.end()) continue;
+        it.value().remove(name);
+        if (it.value().isEmpty()) m_tagIndex.erase(it);
+    }
+}
+
+quint64 flashcardManager::addCard(const QString &deckName, const flashcard &card)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    deck *d = findDeck(deckName);
+    if (!d) return 0;
+
+    const quint64 id = d->addCard(internCard(card));
+    const flashcard &stored = *d->findCard(id);
+    if (m_searchBuilt) m_search.addCard(deckName, id, stored.getQuestion(), stored.getAnswer());
+    if (!m_scheduleStale.contains(deckName)) m_schedule.addNew(deckName, id, QDateTime::currentSecsSinceEpoch());
+
+    QJsonObject r;
+    r["op"] = "addCard";
+    r["name"] = deckName;
+    r["card"] = flashcardToJson(stored);
+    journal(r);
+    return id;
+}
+
+bool flashcardManager::updateCardById(const QString &deckName, quint64 id, const flashcard &card)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    deck *d = findDeck(deckName);
+    if (!d || !d->updateCardById(id, internCard(card))) return false;
+    const flashcard &stored = *d->findCard(id);
+    if (m_searchBuilt) m_search.updateCard(deckName, id, stored.getQuestion(), stored.getAnswer());
+
+    QJsonObject r;
+    r["op"] = "updateCard";
+    r["name"] = deckName;
+    r["id"] = idToJson(id);
+    r["card"] = flashcardToJson(stored);
+    journal(r);
+    return true;
+}
+
+bool flashcardManager::removeCardById(const QString &deckName, quint64 id)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    deck *d = findDeck(deckName);
+    if (!d || !d->removeCardById(id)) return false;
+    if (m_searchBuilt) m_search.removeCard(deckName, id);
+    m_schedule.removeCard(deckName, id);
+    m_scheduleDirty = true;
+    m_reviewStats.removeCard(deckName, id);
+
+    QJsonObject r;
+    r["op"] = "removeCard";
+    r["name"] = deckName;
+    r["id"] = idToJson(id);
+    journal(r);
+    return true;
+}
+
+// Resolves a row to its card id under the lock
+quint64 flashcardManager::cardIdAt(const QString &deckName, int index)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    deck *d = findDeck(deckName);
+    return d ? d->idAt(index) : 0;
+}
+
+bool flashcardManager::updateCard(const QString &deckName, int index, const flashcard &card)
+{
+    const quint64 id = cardIdAt(deckName, index);
+    return id != 0 && updateCardById(deckName, id, card);
+}
+
+bool flashcardManager::removeCard(const QString &deckName, int index)
+{
+    const quint64 id = cardIdAt(deckName, index);
+    return id != 0 && removeCardById(deckName, id);
+}
+
+// Materializes every deck that is still only in the index
+void flashcardManager::loadAllDecks()
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    const QStringList names = m_unloaded.keys();
+    for (const QString& name : names) findDeck(name);
+}
+
+bool flashcardManager::setDeckTag(const QString &deckName, const QString &tag)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    deck *d = findDeck(deckName);
+    if (!d) return false;
+
+    d->setTag(tag);
+    indexDeckTags(deckName, tag);
+
+    QJsonObject r;
+    r["op"] = "setTag";
+    r["name"] = deckName;
+    r["tag"] = tag;
+    journal(r);
+    return true;
+}
+
+static QString uniqueNameForImport(const std::function<bool(const QString&)>& taken, QString base)
+{
+    if (!taken(base)) return base;
+    int i = 2;
+    while (taken(QString("%1 (%2)").arg(base).arg(i))) ++i;
+    return QString("%1 (%2)").arg(base).arg(i);
+}
+
+static QString normalizedCardText(const QString &text)
+{
+    return text.simplified().toCaseFolded();
+}
+
+// FNV-1a over the UTF-16 units
+static quint64 cardTextHash(const QString &text)
+{
+    quint64 h = 1469598103934665603ULL;
+    for (const QChar c : text) {
+        h ^= c.unicode();
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+// Writes one deck object; progress counts cards across the whole export
+static bool writeDeckStreaming(JsonStreamWriter& w, const deck& d, qint64& done, qint64 total,
+                               const flashcardManager::ProgressCallback& progress)
+{
+    w.beginObject();
+    w.key("name");
+    w.value(d.getName());
+    w.key("tag");
+    w.value(d.getTag());
+    w.key("cards");
+    w.beginArray();
+    for (const flashcard& fc : d) {
+        w.beginObject();
+        w.key("id");
+        w.value(idToJson(fc.getId()));
+        w.key("question");
+        w.value(fc.getQuestion());
+        w.key("answer");
+        w.value(fc.getAnswer());
+        w.endObject();
+
+        if (++done % 1024 == 0 && progress && !progress(done, total)) return false;
+    }
+    w.endArray();
+    w.endObject();
+    return true;
+}
+
+bool flashcardManager::writeDecksStreaming(const QString& filePath, const QVector<deck>& decks, bool singleDeck,
+                                           bool compact, QString *errorOut, const ProgressCallback& progress)
+{
+    ScopedTimer timer("export.write", "export");
+    QSaveFile f(filePath);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = "Could not open file for writing.";
+        return false;
+    }
+
+    qint64 total = 0;
+    for (const deck& d : decks) total += d.getSize();
+    Instrumentation::instance().counter("export.cards", total, "export");
+    qint64 done = 0;
+
+    JsonStreamWriter w(&f, !compact);
+    w.beginObject();
+    w.key("version");
+    w.value(1);
+
+    bool completed = true;
+    if (singleDeck && !decks.isEmpty()) {
+        w.key("deck");
+        completed = writeDeckStreaming(w, decks.first(), done, total, progress);
+    } else {
+        w.key("decks");
+        w.beginArray();
+        for (const deck& d : decks) {
+            completed = writeDeckStreaming(w, d, done, total, progress);
+            if (!completed) break;
+        }
+        if (completed) w.endArray();
+    }
+
+    if (!completed) {
+        // Leave any existing file at filePath untouched
+        f.cancelWriting();
+        if (errorOut) *errorOut = "Export cancelled.";
+        return false;
+    }
+
+    w.endObject();
+    if (!w.finish() || !f.commit()) {
+        if (errorOut) *errorOut = "Could not write file.";
+        return false;
+    }
+
+    if (progress) progress(total, total);
+    return true;
+}
+
+QVector<deck> flashcardManager::snapshotDecks(const QStringList& names)
+{
+    (void)instance();
+
+    if (names.isEmpty()) loadAllDecks();
+
+    QMutexLocker lock(&m_mutex);
+    QVector<deck> out;
+    if (names.isEmpty()) {
+        out.reserve(decks.size());
+        for (auto it = decks.constBegin(); it != decks.constEnd(); ++it) out.append(it.value());
+    } else {
+        for (const QString& name : names) {
+            if (const deck *d = findDeck(name)) out.append(*d);
+        }
+    }
+    return out;
+}
+
+bool flashcardManager::exportDeckToFile(const QString& deckName, const QString& filePath, QString *errorOut)
+{
+    const QVector<deck> snapshot = snapshotDecks(QStringList() << deckName);
+    if (snapshot.isEmpty()) {
+        if (errorOut) *errorOut = "Deck not found.";
+        return false;
+    }
+    return writeDecksStreaming(filePath, snapshot, true, false, errorOut);
+}
+
+bool flashcardManager::exportAllDecksToFile(const QString& filePath, QString *errorOut)
+{
+    return writeDecksStreaming(filePath, snapshotDecks(), false, false, errorOut);
+}
+
+// Reads the fields of a card object whose '{' was just consumed
+static bool parseCardFields(JsonStreamReader& r, flashcard& out)
+{
+    for (;;) {
+        JsonStreamReader::Token t = r.next();
+        if (t == JsonStreamReader::EndObject) return true;
+        if (t != JsonStreamReader::Key) return false;
+
+        const QString key = r.stringValue();
+        t = r.next();
+        if (key == "id" && t == JsonStreamReader::String) out.setId(r.stringValue().toULongLong());
+        else if (key == "id" && t == JsonStreamReader::Number) out.setId(quint64(r.numberValue()));
+        else if (key == "question" && t == JsonStreamReader::String) out.setQuestion(r.stringValue());
+        else if (key == "answer" && t == JsonStreamReader::String) out.setAnswer(r.stringValue());
+        else if (!r.skipValue(t)) return false;
+    }
+}
+
+// Reads the elements of a "cards" array whose '[' was just consumed. keepGoing() is polled between batches.
+static bool parseCardArray(JsonStreamReader& r, deck& out, const std::function<bool()>& keepGoing, bool *cancelled)
+{
+    int parsed = 0;
+    for (;;) {
+        const JsonStreamReader::Token t = r.next();
+        if (t == JsonStreamReader::EndArray) return true;
+        if (t == JsonStreamReader::BeginObject) {
+            flashcard fc;
+            if (!parseCardFields(r, fc)) return false;
+            out.addCard(std::move(fc));
+        } else if (!r.skipValue(t)) {
+            return false;
+        }
+
+        if (++parsed % 1024 == 0 && !keepGoing()) {
+            *cancelled = true;
+            return false;
+        }
+    }
+}
+
+// Reads the fields of a deck object (or of a {"deck": {...}} wrapper) whose '{' was just
+// consumed. Cards are appended as they're parsed.
+static bool parseDeckFields(JsonStreamReader& r, deck& out, const std::function<bool()>& keepGoing, bool *cancelled)
+{
+    for (;;) {
+        JsonStreamReader::Token t = r.next();
+        if (t == JsonStreamReader::EndObject) return true;
+        if (t != JsonStreamReader::Key) return false;
+
+        const QString key = r.stringValue();
+        t = r.next();
+        if (key == "deck" && t == JsonStreamReader::BeginObject) {
+            if (!parseDeckFields(r, out, keepGoing, cancelled)) return false;
+        } else if (key == "name" && t == JsonStreamReader::String) {
+            out.setName(r.stringValue());
+        } else if (key == "tag" && t == JsonStreamReader::String) {
+            out.setTag(r.stringValue());
+        } else if (key == "cards" && t == JsonStreamReader::BeginArray) {
+            if (!parseCardArray(r, out, keepGoing, cancelled)) return false;
+        } else if (!r.skipValue(t)) {
+            return false;
+        }
+    }
+}
+
+// Reads any JSON deck file: a {"decks": [...]} library export yields each listed deck,
+// a single-deck export ({"deck": {...}} or a raw deck object) yields one.
+static bool readDecksJson(const QString& path, QVector<deck>& out, QString *errorOut,
+                          const flashcardManager::ProgressCallback& progress = flashcardManager::ProgressCallback())
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for reading.").arg(path);
+        return false;
+    }
+
+    const qint64 total = f.size();
+    JsonStreamReader r(&f);
+    auto keepGoing = [&]() { return !progress || progress(r.bytesConsumed(), total); };
+
+    deck single("", "");
+    QVector<deck> listed;
+    bool isLibrary = false;
+    bool cancelled = false;
+    bool ok = r.next() == JsonStreamReader::BeginObject;
+    while (ok) {
+        JsonStreamReader::Token t = r.next();
+        if (t == JsonStreamReader::EndObject) break;
+        if (t != JsonStreamReader::Key) {
+            ok = false;
+            break;
+        }
+
+        const QString key = r.stringValue();
+        t = r.next();
+        if (key == "decks" && t == JsonStreamReader::BeginArray) {
+            isLibrary = true;
+            for (;;) {
+                t = r.next();
+                if (t == JsonStreamReader::EndArray) break;
+                if (t == JsonStreamReader::BeginObject) {
+                    deck d("", "");
+                    if (!(ok = parseDeckFields(r, d, keepGoing, &cancelled))) break;
+                    listed.append(std::move(d));
+                } else if (!(ok = r.skipValue(t))) {
+                    break;
+                }
+            }
+        } else if (key == "deck" && t == JsonStreamReader::BeginObject) {
+            ok = parseDeckFields(r, single, keepGoing, &cancelled);
+        } else if (key == "name" && t == JsonStreamReader::String) {
+            single.setName(r.stringValue());
+        } else if (key == "tag" && t == JsonStreamReader::String) {
+            single.setTag(r.stringValue());
+        } else if (key == "cards" && t == JsonStreamReader::BeginArray) {
+            ok = parseCardArray(r, single, keepGoing, &cancelled);
+        } else {
+            ok = r.skipValue(t);
+        }
+    }
+
+    if (!ok) {
+        if (errorOut) {
+            if (cancelled) *errorOut = "Import cancelled.";
+            else if (!r.errorString().isEmpty()) *errorOut = QString("Invalid JSON in %1: %2").arg(path, r.errorString());
+            else *errorOut = QString("Invalid JSON in %1.").arg(path);
+        }
+        return false;
+    }
+
+    if (isLibrary) out += listed;
+    else out.append(single);
+    if (progress) progress(total, total);
+    return true;
+}
+
+bool flashcardManager::readDecksFromFile(const QString& filePath, QVector<deck>& out, QString *errorOut,
+                                         const ProgressCallback& progress, CsvImportStats *csvStats)
+{
+    ScopedTimer timer("import.read", "import");
+    out.clear();
+    if (DeckBundleReader::isBundle(filePath)) return readBundle(filePath, out, errorOut, nullptr, progress);
+
+    if (!CsvDeckReader::isCsvPath(filePath)) return readDecksJson(filePath, out, errorOut, progress);
+
+    ScopedTimer csvTimer("import.csv", "import");
+    CsvImportStats stats;
+    deck d;
+    if (!CsvDeckReader::read(filePath, d, errorOut, &stats, 0, progress)) return false;
+    Instrumentation::instance().counter("import.csvRows", stats.rows, "import");
+    Instrumentation::instance().counter("import.csvRowsPerSecond", qint64(stats.rowsPerSecond()), "import");
+    if (csvStats) *csvStats = stats;
+    out.append(d);
+    return true;
+}
+
+// Each deck becomes one block holding its single-deck export JSON
+bool flashcardManager::writeBundle(const QString& filePath, const QVector<deck>& decks, QString *errorOut,
+                                   DeckBundleStats *stats, const ProgressCallback& progress)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    DeckBundleWriter writer(filePath);
+    if (!writer.open(errorOut)) return false;
+
+    for (int i = 0; i < decks.size(); ++i) {
+        QJsonObject root;
+        root["version"] = 1;
+        root["deck"] = deckToJson(decks[i]);
+        if (!writer.addBlock(decks[i].getName(), decks[i].getSize(), QJsonDocument(root).toJson(QJsonDocument::Compact))) {
+            writer.cancel();
+            if (errorOut) *errorOut = "Could not write file.";
+            return false;
+        }
+        if (progress && !progress(i + 1, decks.size())) {
+            writer.cancel();
+            if (errorOut) *errorOut = "Export cancelled.";
+            return false;
+        }
+    }
+
+    if (!writer.finish(errorOut)) return false;
+
+    if (stats) {
+        stats->rawBytes = writer.rawBytes();
+        stats->compressedBytes = writer.compressedBytes();
+        stats->elapsedMs = timer.elapsed();
+    }
+    return true;
+}
+
+static bool deckFromBundleBlock(DeckBundleReader& reader, int index, deck& out, qint64 *rawBytes, QString *errorOut)
+{
+    QByteArray json;
+    if (!reader.readBlock(index, json, errorOut)) return false;
+    if (rawBytes) *rawBytes += json.size();
+
+    const QJsonDocument doc = QJsonDocument::fromJson(json);
+    if (!doc.isObject() || !doc.object().value("deck").isObject()) {
+        if (errorOut) *errorOut = QString("Deck %1 is damaged in the bundle.").arg(reader.entry(index).name);
+        return false;
+    }
+    out = deckFromJson(doc.object().value("deck").toObject());
+    return true;
+}
+
+bool flashcardManager::readBundle(const QString& filePath, QVector<deck>& out, QString *errorOut,
+                                  DeckBundleStats *stats, const ProgressCallback& progress)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    DeckBundleReader reader;
+    if (!reader.open(filePath, errorOut)) return false;
+
+    qint64 rawBytes = 0;
+    qint64 compressedBytes = 0;
+    out.reserve(out.size() + reader.deckCount());
+    for (int i = 0; i < reader.deckCount(); ++i) {
+        deck d;
+        if (!deckFromBundleBlock(reader, i, d, &rawBytes, errorOut)) return false;
+        compressedBytes += reader.entry(i).compressedSize;
+        out.append(d);
+
+        if (progress && !progress(i + 1, reader.deckCount())) {
+            if (errorOut) *errorOut = "Import cancelled.";
+            return false;
+        }
+    }
+
+    if (stats) {
+        stats->rawBytes = rawBytes;
+        stats->compressedBytes = compressedBytes;
+        stats->elapsedMs = timer.elapsed();
+    }
+    return true;
+}
+
+// Inflates only the requested deck's block
+bool flashcardManager::extractDeckFromBundle(const QString& filePath, const QString& deckName, deck& out,
+                                             QString *errorOut)
+{
+    DeckBundleReader reader;
+    if (!reader.open(filePath, errorOut)) return false;
+
+    const int index = reader.indexOf(deckName);
+    if (index < 0) {
+        if (errorOut) *errorOut = "Deck not found in bundle.";
+        return false;
+    }
+    return deckFromBundleBlock(reader, index, out, nullptr, errorOut);
+}
+
+bool flashcardManager::exportAllDecksToBundle(const QString& filePath, QString *errorOut, DeckBundleStats *stats)
+{
+    return writeBundle(filePath, snapshotDecks(), errorOut, stats);
+}
+
+QString flashcardManager::addImportedDeck(deck d)
+{
+    (void)instance();
+    ScopedTimer timer("import.add", "import");
+
+    QString name = d.getName().trimmed();
+    if (name.isEmpty()) name = "Imported Deck";
+
+    name = uniqueNameForImport([this](const QString& n) { return hasDeck(n); }, name);
+    d.setName(name);
+
+    // addDeck will journal the new deck
+    addDeck(d);
+    return name;
+}
+
+// Ids are only trusted between decks of one lineage (an earlier export of the deck, or a
+// copy of it); unrelated decks can share ids, e.g. the positional ids older versions gave.
+// Most incoming cards whose id exists here must still agree on question or answer.
+static bool sharesLineage(const deck& existing, const deck& incoming)
+{
+    int overlap = 0;
+    int agree = 0;
+    for (const flashcard& card : incoming) {
+        const flashcard *fc = card.getId() != 0 ? existing.findCard(card.getId()) : nullptr;
+        if (!fc) continue;
+        ++overlap;
+        if (normalizedCardText(fc->getQuestion()) == normalizedCardText(card.getQuestion())
+            || normalizedCardText(fc->getAnswer()) == normalizedCardText(card.getAnswer())) {
+            ++agree;
+        }
+    }
+    return overlap > 0 && agree * 2 > overlap;
+}
+
+MergeImportSummary flashcardManager::mergeImportedDecks(QVector<deck> incoming)
+{
+    (void)instance();
+    ScopedTimer timer("import.merge", "import");
+
+    MergeImportSummary summary;
+    QMutexLocker lock(&m_mutex);
+    QVector<QJsonObject> records;   // one per deck, journaled together at the end
+    for (deck& in : incoming) {
+        QString name = in.getName().trimmed();
+        if (name.isEmpty()) name = "Imported Deck";
+        ++summary.decks;
+
+        deck *d = findDeck(name);
+        if (!d) {
+            in.setName(name);
+            internDeck(in);
+            indexDeckTags(name, in.getTag());
+            if (m_searchBuilt) indexCards(in);
+            decks.insert(name, in);
+            m_scheduleStale.insert(name);
+            ++summary.createdDecks;
+            summary.added += in.getSize();
+
+            QJsonObject r;
+            r["op"] = "addDeck";
+            r["deck"] = deckToJson(in);
+            records.append(r);
+            continue;
+        }
+
+        // One pass over the existing deck, then one lookup per incoming card
+        QHash<quint64, quint64> byQuestion;   // hash of normalized question -> card id
+        byQuestion.reserve(d->getSize());
+        for (const flashcard& fc : *d) {
+            const quint64 key = cardTextHash(normalizedCardText(fc.getQuestion()));
+            if (!byQuestion.contains(key)) byQuestion.insert(key, fc.getId());
+        }
+
+        // What changed is journaled as a patch of this deck
+        DeckPatch patch;
+        patch.deckName = name;
+        QHash<quint64, int> touched;   // card added or changed by this merge -> its patch record
+        const bool byId = sharesLineage(*d, in);
+        for (const flashcard& card : std::as_const(in)) {
+            const QString question = normalizedCardText(card.getQuestion());
+            const quint64 key = cardTextHash(question);
+
+            quint64 match = byId && card.getId() != 0 && d->contains(card.getId()) ? card.getId() : 0;
+            if (match == 0) {
+                auto it = byQuestion.constFind(key);
+                if (it != byQuestion.constEnd()
+                    && normalizedCardText(d->findCard(it.value())->getQuestion()) == question) {
+                    match = it.value();
+                }
+            }
+
+            DeckPatchRecord pr;
+            pr.question = card.getQuestion();
+            pr.answer = card.getAnswer();
+            if (match == 0) {
+                const quint64 id = d->addCard(internCard(flashcard(card.getQuestion(), card.getAnswer(), card.getId())));
+                if (!byQuestion.contains(key)) byQuestion.insert(key, id);
+                if (m_searchBuilt) m_search.addCard(name, id, card.getQuestion(), card.getAnswer());
+                ++summary.added;
+                pr.op = DeckPatchRecord::Add;
+                pr.id = id;
+                touched.insert(id, patch.records.size());
+                patch.records.append(pr);
+                continue;
+            }
+
+            const flashcard *existing = d->findCard(match);
+            if (normalizedCardText(existing->getQuestion()) == question
+                && normalizedCardText(existing->getAnswer()) == normalizedCardText(card.getAnswer())) {
+                ++summary.unchanged;
+                continue;
+            }
+            auto prior = touched.constFind(match);
+            if (prior != touched.constEnd()) {
+                // Already in the patch: one record per card, carrying the final text
+                patch.records[prior.value()].question = card.getQuestion();
+                patch.records[prior.value()].answer = card.getAnswer();
+            } else {
+                pr.op = DeckPatchRecord::Modify;
+                pr.id = match;
+                pr.baseHash = DeckPatch::cardHash(existing->getQuestion(), existing->getAnswer());
+                touched.insert(match, patch.records.size());
+                patch.records.append(pr);
+            }
+            d->updateCardById(match, internCard(flashcard(card.getQuestion(), card.getAnswer())));
+            if (m_searchBuilt) m_search.updateCard(name, match, card.getQuestion(), card.getAnswer());
+            ++summary.updated;
+        }
+
+        // Tags are merged, not replaced
+        QStringList tags = d->tags();
+        for (const QString& t : in.tags()) {
+            if (!tags.contains(t, Qt::CaseInsensitive)) tags.append(t);
+        }
+        const QString tag = tags.join(", ");
+        if (tag != d->getTag()) {
+            d->setTag(m_interning ? m_strings.intern(tag) : tag);
+            indexDeckTags(name, tag);
+            patch.tagChanged = true;
+            patch.tag = tag;
+        }
+
+        if (!patch.isEmpty()) {
+            m_scheduleStale.insert(name);
+            QJsonObject r;
+            r["op"] = "applyPatch";
+            r["name"] = name;
+            r["patch"] = patch.toJson();
+            records.append(r);
+        }
+    }
+
+    journalBatch(records);
+    return summary;
+}
+
+bool flashcardManager::mergeDeckFromFile(const QString& filePath, MergeImportSummary *summaryOut, QString *errorOut)
+{
+    (void)instance();
+
+    QVector<deck> read;
+    if (!readDecksFromFile(filePath, read, errorOut)) return false;
+
+    const MergeImportSummary summary = mergeImportedDecks(read);
+    if (summaryOut) *summaryOut = summary;
+    return true;
+}
+
+bool flashcardManager::exportDeckPatch(const QString& deckName, const QString& baseFilePath, const QString& patchPath,
+                                       QString *errorOut, DeckPatch *patchOut)
+{
+    QVector<deck> base;
+    if (!readDecksFromFile(baseFilePath, base, errorOut)) return false;
+
+    // A library export lists every deck: use the one of this name. A file holding a single
+    // deck under another name is taken as an export from before a rename.
+    int baseIndex = -1;
+    for (int i = 0; i < base.size() && baseIndex < 0; ++i) {
+        if (base[i].getName() == deckName) baseIndex = i;
+    }
+    if (baseIndex < 0 && base.size() == 1) baseIndex = 0;
+    if (baseIndex < 0) {
+        if (errorOut) *errorOut = QString("%1 does not contain deck %2.").arg(baseFilePath, deckName);
+        return false;
+    }
+
+    const QVector<deck> current = snapshotDecks(QStringList() << deckName);
+    if (current.isEmpty()) {
+        if (errorOut) *errorOut = "Deck not found.";
+        return false;
+    }
+
+    DeckPatch patch = DeckPatch::diff(base[baseIndex], current.first());
+    patch.deckName = deckName;
+    if (!patch.write(patchPath, errorOut)) return false;
+    if (patchOut) *patchOut = patch;
+    return true;
+}
+
+bool flashcardManager::applyDeckPatch(const DeckPatch& patch, QString *errorOut)
+{
+    (void)instance();
+
+    QMutexLocker lock(&m_mutex);
+    deck *d = findDeck(patch.deckName);
+    if (!d) {
+        if (errorOut) *errorOut = QString("Deck %1 not found.").arg(patch.deckName);
+        return false;
+    }
+    if (!patch.check(*d, errorOut)) return false;
+
+    patch.apply(*d);
+    if (patch.tagChanged) indexDeckTags(patch.deckName, d->getTag());
+    for (const DeckPatchRecord& r : patch.records) {
+        if (r.op == DeckPatchRecord::Delete) m_schedule.removeCard(patch.deckName, r.id);
+    }
+    m_scheduleDirty = true;
+    if (patch.count(DeckPatchRecord::Add) > 0) m_scheduleStale.insert(patch.deckName);
+    if (m_searchBuilt) {
+        for (const DeckPatchRecord& r : patch.records) {
+            if (r.op == DeckPatchRecord::Delete) m_search.removeCard(patch.deckName, r.id);
+            else m_search.updateCard(patch.deckName, r.id, r.question, r.answer);
+        }
+    }
+
+    QJsonObject r;
+    r["op"] = "applyPatch";
+    r["name"] = patch.deckName;
+    r["patch"] = patch.toJson();
+    journal(r);
+    return true;
+}
+
+bool flashcardManager::applyDeckPatchFile(const QString& patchPath, QString *errorOut, DeckPatch *patchOut)
+{
+    DeckPatch patch;
+    if (!DeckPatch::read(patchPath, patch, errorOut)) return false;
+    if (!applyDeckPatch(patch, errorOut)) return false;
+    if (patchOut) *patchOut = patch;
+    return true;
+}
+
+bool flashcardManager::importDeckFromFile(const QString& filePath, QString *importedNameOut, QString *errorOut)
+{
+    (void)instance();
+
+    QVector<deck> read;
+    if (!readDecksFromFile(filePath, read, errorOut)) return false;
+
+    Batch batch(*this);
+    QStringList names;
+    for (const deck& d : read) names.append(addImportedDeck(d));
+    if (importedNameOut) *importedNameOut = names.join(", ");
+    return true;
+}
+
+// Parses every file on a thread pool, then adds the decks in one pass under the lock and
+// journals them as one batch of addDeck records.
+BulkImportResult flashcardManager::importDecksFromFiles(const QStringList& filePaths,
+                                                        const ProgressCallback& progress, int maxThreads)
+{
+    (void)instance();
+    ScopedTimer timer("import.bulk", "import");
+
+    BulkImportResult result;
+    const int n = filePaths.size();
+    QVector<QVector<deck>> parsed(n);
+    QVector<QString> errors(n);
+    QVector<bool> ok(n, false);
+
+    std::atomic<int> done{0};
+    std::atomic<bool> cancelled{false};
+    QMutex progressMutex;   // the callback is not required to be thread-safe
+
+    // Workers only touch their own slot; take the pointers up front so nothing detaches
+    QVector<deck> *parsedOut = parsed.data();
+    QString *errorsOut = errors.data();
+    bool *okOut = ok.data();
+
+    QThreadPool pool;
+    if (maxThreads > 0) pool.setMaxThreadCount(maxThreads);
+    for (int i = 0; i < n; ++i) {
+        pool.start([&, i]() {
+            if (cancelled.load()) return;
+            okOut[i] = readDecksFromFile(filePaths[i], parsedOut[i], &errorsOut[i]);
+
+            const int finished = ++done;
+            if (progress) {
+                QMutexLocker lock(&progressMutex);
+                if (!progress(finished, n)) cancelled = true;
+            }
+        });
+    }
+    pool.waitForDone();
+
+    if (cancelled.load()) {
+        result.cancelled = true;
+        return result;
+    }
+
+    {
+        QMutexLocker lock(&m_mutex);
+        auto taken = [this](const QString& name) { return decks.contains(name) || m_unloaded.contains(name); };
+        QVector<QJsonObject> records;
+
+        for (int i = 0; i < n; ++i) {
+            if (!ok[i]) {
+                result.failedFiles.append(filePaths[i]);
+                result.errors.append(errors[i].isEmpty() ? QString("Could not import deck.") : errors[i]);
+                continue;
+            }
+
+            for (deck &d : parsed[i]) {
+                QString name = d.getName().trimmed();
+                if (name.isEmpty()) name = "Imported Deck";
+                name = uniqueNameForImport(taken, name);
+                d.setName(name);
+                internDeck(d);
+                indexDeckTags(name, d.getTag());
+                if (m_searchBuilt) indexCards(d);
+
+                decks.insert(name, d);
+                m_scheduleStale.insert(name);
+                result.importedNames.append(name);
+
+                QJsonObject r;
+                r["op"] = "addDeck";
+                r["deck"] = deckToJson(d);
+                records.append(r);
+            }
+        }
+        journalBatch(records);
+    }
+    return result;
+}
+
+BulkImportResult flashcardManager::importDecksFromDirectory(const QString& dirPath,
+                                                            const ProgressCallback& progress, int maxThreads)
+{
+    const QStringList filters = QStringList() << "*.json" << "*.csv" << "*.tsv" << "*.tab" << "*.fcbz";
+    const QFileInfoList files = QDir(dirPath).entryInfoList(filters, QDir::Files, QDir::Name);
+
+    QStringList paths;
+    paths.reserve(files.size());
+    for (const QFileInfo& fi : files) paths.append(fi.absoluteFilePath());
+    return importDecksFromFiles(paths, progress, maxThreads);
+}
+
+bool flashcardManager::convertJsonToBinary(const QString& jsonPath, const QString& binaryPath, QString *errorOut)
+{
+    QVector<deck> all;
+    if (!readDecksJson(jsonPath, all, errorOut)) return false;
+    return BinaryDeckStore::write(binaryPath, all, errorOut);
+}
+
+bool flashcardManager::convertBinaryToJson(const QString& binaryPath, const QString& jsonPath, QString *errorOut)
+{
+    BinaryDeckStore store;
+    if (!store.open(binaryPath, errorOut)) return false;
+
+    QVector<deck> all;
+    all.reserve(store.deckCount());
+    for (int i = 0; i < store.deckCount(); ++i) {
+        all.append(store.deckAt(i).toDeck());
+    }
+    return writeDecksStreaming(jsonPath, all, false, false, errorOut);
+}
+
+// Times the JSON load path against opening/scanning/materializing the same library from
+// a binary store. Both files should hold the same decks (see convertJsonToBinary).
+StoreLoadComparison flashcardManager::compareLoadPaths(const QString& jsonPath, const QString& binaryPath)
+{
+    StoreLoadComparison result;
+    result.jsonBytes = QFileInfo(jsonPath).size();
+    result.binaryBytes = QFileInfo(binaryPath).size();
+
+    QElapsedTimer timer;
+    timer.start();
+    QVector<deck> fromJson;
+    readDecksJson(jsonPath, fromJson, nullptr);
+    result.jsonLoadMs = timer.elapsed();
+
+    timer.restart();
+    BinaryDeckStore store;
+    if (!store.open(binaryPath, nullptr)) return result;
+    result.binaryOpenMs = timer.elapsed();
+
+    timer.restart();
+    size_t checksum = 0;
+    for (int i = 0; i < store.deckCount(); ++i) {
+        const BinaryDeckView view = store.deckAt(i);
+        for (int c = 0; c < view.cardCount(); ++c) {
+            checksum ^= qHash(view.question(c)) ^ qHash(view.answer(c));
+        }
+        result.cards += view.cardCount();
+    }
+    result.binaryScanMs = timer.elapsed();
+    result.decks = store.deckCount();
+
+    timer.restart();
+    QVector<deck> fromBinary;
+    fromBinary.reserve(store.deckCount());
+    for (int i = 0; i < store.deckCount(); ++i) fromBinary.append(store.deckAt(i).toDeck());
+    result.binaryMaterializeMs = timer.elapsed();
+
+    Q_UNUSED(checksum);
+    return result;
 }
@@ -1,26 +1,85 @@
 #ifndef FLASHCARDMANAGER_H
 #define FLASHCARDMANAGER_H
 
+#include <QHash>
+#include <QJsonObject>
 #include <QMap>
+#include <QMutex>
+#include <QSet>
 #include <QStringList>
+#include <functional>
+#include "binarydeckstore.h"
+#include "csvdeckreader.h"
+#include "deckbundle.h"
 #include "deck.h"
+#include "deckindex.h"
+#include "deckjournal.h"
+#include "deckpatch.h"
+#include "duplicatefinder.h"
+#include "persistenceworker.h"
+#include "reviewlog.h"
+#include "reviewscheduler.h"
+#include "reviewstats.h"
+#include "searchindex.h"
+#include "tagquery.h"
 
 /*
  * flashcardManager (Singleton) + JSON persistence + Import/Export
  *
  * Persistence:
- *  - Automatically loads decks from disk on first use.
- *  - Saves decks to disk when add/remove is called.
- *  - Call saveToDisk() after in-place edits (e.g., adding cards inside a DeckWindow).
+ *  - Decks are stored one file per deck under decks/, plus decks/manifest.json.
+ *    Startup reads the manifest and replays decks.journal; a deck's shard is
+ *    parsed the first time getDeck() asks for it.
+ *  - Deck/card mutations made through the manager are appended to decks.journal;
+ *    once the journal grows past the compaction threshold the persistence thread
+ *    rewrites only the shards of decks that changed, then the manifest.
+ *  - A monolithic decks.json from older versions is migrated on first load and
+ *    kept as decks.json.bak.
+ *  - Review schedules (see ReviewScheduler) are journaled per review and
+ *    snapshotted to decks/schedule.json next to the shards.
+ *  - Every answered card is appended to the binary reviews.log (see ReviewLog);
+ *    the writer is buffered and flushed by flush().
+ *  - Call requestSave() after in-place edits made directly on a deck*, and
+ *    flush() before shutdown. saveToDisk() is requestSave() + flush().
  *
  * Import/Export:
- *  - exportDeckToFile(...) writes a single deck as JSON.
+ *  - exportDeckToFile(...) writes a single deck as JSON, streamed to the file.
  *  - importDeckFromFile(...) reads a deck JSON and adds it (renaming on collision).
+ *    The file is tokenized incrementally, never loaded whole.
+ *  - importDecksFromFiles/importDecksFromDirectory parse many decks in parallel.
+ *  - CSV/TSV files (question, answer[, tag]) are accepted wherever JSON decks are.
+ *  - writeBundle/readBundle handle compressed .fcbz bundles; importDeckFromFile
+ *    detects them and imports every deck inside.
+ *  - convertJsonToBinary/convertBinaryToJson move libraries to and from the
+ *    memory-mapped BinaryDeckStore format.
  */
 
+// Outcome of a bulk import; errors[i] explains failedFiles[i]
+struct BulkImportResult
+{
+    QStringList importedNames;
+    QStringList failedFiles;
+    QStringList errors;
+    bool cancelled = false;   // nothing is imported when cancelled
+};
+
+// Outcome of a merge import, summed over the decks in the file
+struct MergeImportSummary
+{
+    int decks = 0;
+    int createdDecks = 0;   // no deck of that name existed; imported whole
+    int added = 0;
+    int updated = 0;
+    int unchanged = 0;
+};
+
 class flashcardManager
 {
 public:
+    // Long-running operations report (done, total) through a ProgressCallback;
+    // returning false from it cancels the operation.
+    using ProgressCallback = std::function<bool(qint64 done, qint64 total)>;
+
     // Singleton access
     static flashcardManager& instance();
 
@@ -28,28 +87,217 @@ public:
     void addDeck(const deck &d);
     deck* getDeck(const QString &name);
     bool removeDeck(const QString &name);
+    bool renameDeck(const QString &oldName, const QString &newName, QString *errorOut = nullptr);   // O(1), no card copies
     QStringList getDeckNames() const;
+    QString getDeckTag(const QString &name) const;   // answered from the index, no load
+    // Tag index: decks are indexed under each of their comma-separated tags.
+    // findDecksByTags takes a TagQuery ("a AND NOT b", "(a OR b) AND c"), returns sorted names.
+    QStringList findDecksByTags(const QString &query, QString *errorOut = nullptr) const;
+    QStringList getAllTags() const;          // normalized (lower-case) tags
+    quint64 deckListVersion() const;         // changes whenever a deck is added, removed or retagged
+    bool hasDeck(const QString &name) const;
+    void loadAllDecks();
+
+    // Card CRUD (journaled). Cards are addressed by their 64-bit id; the index
+    // overloads resolve the row to an id first.
+    quint64 addCard(const QString &deckName, const flashcard &card);   // returns the card's id, 0 on failure
+    bool updateCardById(const QString &deckName, quint64 id, const flashcard &card);
+    bool removeCardById(const QString &deckName, quint64 id);
+    quint64 cardIdAt(const QString &deckName, int index);
+    bool updateCard(const QString &deckName, int index, const flashcard &card);
+    bool removeCard(const QString &deckName, int index);
+    bool setDeckTag(const QString &deckName, const QString &tag);
+
+    // Full-text search over every card's question and answer. The index is built on the
+    // first search (loading all decks) and kept current by the card/deck calls above.
+    QVector<SearchHit> searchCards(const QString &query, SearchIndex::Match mode = SearchIndex::Match::Prefix,
+                                   int limit = 100);
+
+    // Near-duplicate cards across all decks (loads every deck). Signatures are computed
+    // off the lock; progress counts cards. removeDuplicateCards keeps the first card of
+    // each cluster, removes the rest and optionally the decks that leaves empty.
+    QVector<DuplicateCluster> findDuplicateCards(double threshold = 0.8, DuplicateScanStats *stats = nullptr,
+                                                 const ProgressCallback& progress = ProgressCallback());
+    int removeDuplicateCards(const QVector<DuplicateCluster>& clusters, bool removeEmptyDecks = true);
+
+    // Spaced repetition. nextDueCard returns the card with the earliest due time in a deck,
+    // or across the library when deckName is empty; compare its due with the current time.
+    // The library search starts from schedule.json and only loads a deck whose new cards
+    // could come first. reviewCard grades a card on the SM-2 scale (0-5) and journals
+    // its new schedule.
+    DueCard nextDueCard(const QString &deckName = QString());
+    CardSchedule cardSchedule(const QString &deckName, quint64 id) const;
+    bool reviewCard(const QString &deckName, quint64 id, int quality);
+    // Review log: logReview appends one answer (grade 0-5); reviewHistory scans the whole log
+    // for one card, oldest first, following renames of its deck.
+    void logReview(const QString &deckName, quint64 cardId, int grade, quint32 latencyMs);
+    QVector<ReviewRecord> reviewHistory(const QString &deckName, quint64 cardId, QString *errorOut = nullptr);
+    // Per card/deck/tag review aggregates. The first call rebuilds them from the review log;
+    // after that logReview keeps them current.
+    // The returned copy is implicitly shared.
+    ReviewStats reviewStats(QString *errorOut = nullptr);
+
+    // Batches: mutations between beginBatch() and the matching commitBatch() are journaled
+    // as a single record when the outermost batch commits, and no snapshot is written in
+    // between, so a compound operation costs one save and lands whole or not at all.
+    // Batches nest; a flush() inside one is deferred to the commit. Prefer the Batch guard.
+    // Batches belong to the GUI thread (asserted): there is one open batch for the whole
+    // manager, so a mutation another thread journals meanwhile becomes part of it.
+    void beginBatch();
+    void commitBatch();
+
+    class Batch
+    {
+    public:
+        explicit Batch(flashcardManager &manager) : m_manager(manager) { m_manager.beginBatch(); }
+        ~Batch() { m_manager.commitBatch(); }
+        Batch(const Batch&) = delete;
+        Batch& operator=(const Batch&) = delete;
+
+    private:
+        flashcardManager &m_manager;
+    };
 
     // Persistence
-    bool saveToDisk(QString *errorOut = nullptr) const;
+    void requestSave();
+    bool flush(QString *errorOut = nullptr);
+    bool saveToDisk(QString *errorOut = nullptr);
     bool loadFromDisk(QString *errorOut = nullptr);
+    void setCompactionThreshold(qint64 bytes);
+    void setArenaThreshold(int cards);   // decks with this many cards load into arena storage; 0 = never
+    int arenaThreshold() const;
+    // Identical card/tag text loaded or imported is shared through one pool (on by default)
+    void setInterningEnabled(bool enabled);
+    bool isInterningEnabled() const;
+    StringPool::Stats internStats() const;
+    PersistenceWorker::Stats persistenceStats() const;
 
     // Import/Export
-    bool exportDeckToFile(const QString& deckName, const QString& filePath, QString *errorOut = nullptr) const;
-    bool exportAllDecksToFile(const QString& filePath, QString *errorOut = nullptr) const;
+    bool exportDeckToFile(const QString& deckName, const QString& filePath, QString *errorOut = nullptr);
+    bool exportAllDecksToFile(const QString& filePath, QString *errorOut = nullptr);
     bool importDeckFromFile(const QString& filePath, QString *importedNameOut = nullptr, QString *errorOut = nullptr);
 
+    // Decks read by readDecksFromFile() (on any thread) are added here on the GUI thread
+    QString addImportedDeck(deck d);   // applies the collision rules, returns the final name
+
+    // Merge import: each incoming deck is merged into the deck of the same name instead of
+    // being added as a renamed copy. Cards match by id when the incoming deck shares the
+    // existing deck's lineage (most cards with a known id still agree on question or answer),
+    // otherwise by normalized (trimmed, whitespace-collapsed, case-folded) question through a
+    // hash of the existing deck; matches with a different answer are updated, the rest added.
+    // The whole merge is journaled as one batch.
+    MergeImportSummary mergeImportedDecks(QVector<deck> incoming);
+    bool mergeDeckFromFile(const QString& filePath, MergeImportSummary *summaryOut = nullptr,
+                           QString *errorOut = nullptr);
+
+    // Delta updates (.fcpatch): exportDeckPatch diffs a deck against an earlier export of it
+    // (any format readDecksFromFile accepts). applyDeckPatch checks every record against the
+    // deck before changing anything and journals the patch as one record, so it lands whole
+    // or not at all.
+    bool exportDeckPatch(const QString& deckName, const QString& baseFilePath, const QString& patchPath,
+                         QString *errorOut = nullptr, DeckPatch *patchOut = nullptr);
+    bool applyDeckPatch(const DeckPatch& patch, QString *errorOut = nullptr);
+    bool applyDeckPatchFile(const QString& patchPath, QString *errorOut = nullptr, DeckPatch *patchOut = nullptr);
+
+    // Detects the format: .fcbz bundles by their magic (all decks), .csv/.tsv/.tab by
+    // extension (one deck named after the file), anything else as deck JSON: a library
+    // export ({"decks": [...]}) yields each deck, a single-deck export one. JSON is
+    // tokenized through a fixed-size buffer, never read whole; progress counts bytes read.
+    // Safe to run on a worker thread. csvStats is only filled for CSV.
+    static bool readDecksFromFile(const QString& filePath, QVector<deck>& out, QString *errorOut = nullptr,
+                                  const ProgressCallback& progress = ProgressCallback(),
+                                  CsvImportStats *csvStats = nullptr);
+
+    // Compressed bundles (.fcbz): one independently compressed block per deck. progress
+    // counts decks; stats reports raw/compressed bytes and time.
+    static bool writeBundle(const QString& filePath, const QVector<deck>& decks, QString *errorOut = nullptr,
+                            DeckBundleStats *stats = nullptr, const ProgressCallback& progress = ProgressCallback());
+    static bool readBundle(const QString& filePath, QVector<deck>& out, QString *errorOut = nullptr,
+                           DeckBundleStats *stats = nullptr, const ProgressCallback& progress = ProgressCallback());
+    static bool extractDeckFromBundle(const QString& filePath, const QString& deckName, deck& out,
+                                      QString *errorOut = nullptr);
+    bool exportAllDecksToBundle(const QString& filePath, QString *errorOut = nullptr, DeckBundleStats *stats = nullptr);
+
+    // Bulk import: files are parsed concurrently (maxThreads <= 0 uses the ideal thread
+    // count), merged under one lock and saved once. progress counts files. Blocks until done.
+    BulkImportResult importDecksFromFiles(const QStringList& filePaths,
+                                          const ProgressCallback& progress = ProgressCallback(), int maxThreads = 0);
+    BulkImportResult importDecksFromDirectory(const QString& dirPath,
+                                              const ProgressCallback& progress = ProgressCallback(), int maxThreads = 0);
+
+    // Streaming export: decks and cards go straight to the file in chunks. Safe to run on a
+    // worker thread with copies from snapshotDecks() (empty names = all); progress counts cards.
+    static bool writeDecksStreaming(const QString& filePath, const QVector<deck>& decks, bool singleDeck,
+                                    bool compact = false, QString *errorOut = nullptr,
+                                    const ProgressCallback& progress = ProgressCallback());
+    QVector<deck> snapshotDecks(const QStringList& names = QStringList());
+
+    // Optional binary store (.fcdb); JSON stays the interchange format
+    static bool convertJsonToBinary(const QString& jsonPath, const QString& binaryPath, QString *errorOut = nullptr);
+    static bool convertBinaryToJson(const QString& binaryPath, const QString& jsonPath, QString *errorOut = nullptr);
+    static StoreLoadComparison compareLoadPaths(const QString& jsonPath, const QString& binaryPath);
+
     // Config
-    QString storageFilePath() const;
+    QString storageFilePath() const;         // manifest of the sharded layout
+    QString shardDirPath() const;
+    QString journalFilePath() const;
+    QString scheduleFilePath() const;
+    QString reviewLogPath() const;
+    QString legacyStorageFilePath() const;   // monolithic decks.json, migrated on load
 
 private:
     flashcardManager(); // private for singleton
     flashcardManager(const flashcardManager&) = delete;
     flashcardManager& operator=(const flashcardManager&) = delete;
 
+    void journal(QJsonObject record);
+    void journalBatch(QVector<QJsonObject> records);   // caller holds m_mutex
+    void appendToJournal(const QJsonObject &record);
+    bool renameDeckLocked(const QString &oldName, const QString &newName);
+    bool applyRecord(const QJsonObject &record, QHash<QString, qint64> &deckSeq);
+    deck* findDeck(const QString &name);      // caller holds m_mutex
+    deck* loadShard(const QString &name, qint64 *seqOut);
+    bool rebuildIndexFromShards();
+    void internDeck(deck &d);                 // caller holds m_mutex
+    flashcard internCard(const flashcard &card);
+    void indexDeckTags(const QString &name, const QString &tag);   // caller holds m_mutex
+    void unindexDeck(const QString &name);
+    void indexCards(const deck &d);           // caller holds m_mutex
+    void syncSchedule(const QString &name, const deck &d);   // caller holds m_mutex
+    bool writeSnapshotNow(QString *errorOut); // runs on the persistence thread
+
     QMap<QString, deck> decks;
+    QMap<QString, DeckIndexEntry> m_unloaded;   // decks still only on disk
     bool m_loaded = false;
-    bool m_suppressAutosave = false;
+    bool m_suppressAutosave = false;        // set while a batch is open
+    int m_batchDepth = 0;
+    QVector<QJsonObject> m_batchRecords;    // journal records of the open batch
+    bool m_snapshotDeferred = false;        // a snapshot was due while the batch was open
+    bool m_migrationPending = false;
+    bool m_sweepShards = false;             // every shard on disk was accounted for at load
+    QSet<QString> m_freshIdDecks;           // decks whose id-less cards got ids during loadFromDisk()
+
+    mutable QMutex m_mutex;                 // guards decks, journal and seq against the save thread
+    DeckJournal m_journal;
+    qint64 m_seq = 0;                       // seq of the last journaled mutation
+    qint64 m_compactThreshold = 1 << 20;    // journal bytes before compaction
+    int m_arenaThreshold = 0;
+    StringPool m_strings;                   // guarded by m_mutex
+    bool m_interning = true;
+    QHash<QString, QSet<QString>> m_tagIndex;    // tag key -> deck names; guarded by m_mutex
+    QHash<QString, QStringList> m_deckTagKeys;   // deck name -> its keys in m_tagIndex
+    quint64 m_deckListVersion = 0;
+    SearchIndex m_search;                        // guarded by m_mutex; empty until the first search
+    bool m_searchBuilt = false;
+    ReviewScheduler m_schedule;                  // guarded by m_mutex; new cards join on first use
+    bool m_scheduleDirty = false;                // changed since schedule.json was written
+    QSet<QString> m_scheduleStale;               // decks whose new cards may be missing from m_schedule
+    ReviewLogWriter m_reviewLog;                 // has its own lock; appended to under m_mutex
+    ReviewStats m_reviewStats;                   // guarded by m_mutex; empty until the first query
+    bool m_reviewStatsBuilt = false;
+
+    // Declared last so it is stopped (and drained) before the members above go away
+    PersistenceWorker m_persistence;
 };
 
 #endif // FLASHCARDMANAGER_H
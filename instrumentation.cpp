@@ -0,0 +1,148 @@
+#include "instrumentation.h"
+#include "jsonstreamwriter.h"
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <QThread>
+
+static const int DefaultCapacity = 64 * 1024;
+
+Instrumentation::Instrumentation()
+    : m_ring(DefaultCapacity)
+{
+    m_clock.start();
+}
+
+Instrumentation& Instrumentation::instance()
+{
+    static Instrumentation inst;
+    return inst;
+}
+
+void Instrumentation::setEnabled(bool enabled)
+{
+    m_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Instrumentation::setCapacity(int events)
+{
+    QMutexLocker lock(&m_mutex);
+    m_ring = QVector<TraceEvent>(qMax(1, events));
+    m_written = 0;
+}
+
+void Instrumentation::record(const char *name, const char *category, qint64 startNs, qint64 durationNs)
+{
+    if (!isEnabled()) return;
+    TraceEvent e;
+    e.name = name;
+    e.category = category;
+    e.startNs = startNs;
+    e.durationNs = durationNs;
+    push(e);
+}
+
+void Instrumentation::counter(const char *name, qint64 value, const char *category)
+{
+    if (!isEnabled()) return;
+    TraceEvent e;
+    e.name = name;
+    e.category = category;
+    e.startNs = now();
+    e.value = value;
+    push(e);
+}
+
+// The lock is only ever held for one slot copy
+void Instrumentation::push(const TraceEvent &e)
+{
+    TraceEvent stamped = e;
+    stamped.threadId = quint64(quintptr(QThread::currentThreadId()));
+
+    QMutexLocker lock(&m_mutex);
+    m_ring[int(m_written % m_ring.size())] = stamped;
+    ++m_written;
+}
+
+QVector<TraceEvent> Instrumentation::events() const
+{
+    QMutexLocker lock(&m_mutex);
+    const int size = m_ring.size();
+    const int kept = int(qMin<qint64>(m_written, size));
+    const int first = int((m_written - kept) % size);
+
+    QVector<TraceEvent> out;
+    out.reserve(kept);
+    for (int i = 0; i < kept; ++i) out.append(m_ring[(first + i) % size]);
+    return out;
+}
+
+qint64 Instrumentation::droppedEvents() const
+{
+    QMutexLocker lock(&m_mutex);
+    return qMax<qint64>(0, m_written - m_ring.size());
+}
+
+void Instrumentation::clear()
+{
+    QMutexLocker lock(&m_mutex);
+    m_written = 0;
+}
+
+// Trace-event format: "X" complete events with ts/dur, "C" counter samples; times in microseconds
+bool Instrumentation::exportChromeTrace(const QString &path, QString *errorOut) const
+{
+    const QVector<TraceEvent> list = events();
+
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for writing.").arg(path);
+        return false;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid();
+    JsonStreamWriter w(&f, false);
+    w.beginObject();
+    w.key("displayTimeUnit");
+    w.value("ms");
+    w.key("traceEvents");
+    w.beginArray();
+    for (const TraceEvent &e : list) {
+        w.beginObject();
+        w.key("name");
+        w.value(e.name);
+        w.key("cat");
+        w.value(e.category);
+        w.key("ph");
+        w.value(e.durationNs < 0 ? "C" : "X");
+        w.key("ts");
+        w.value(e.startNs / 1000.0);
+        if (e.durationNs >= 0) {
+            w.key("dur");
+            w.value(e.durationNs / 1000.0);
+        } else {
+            w.key("args");
+            w.beginObject();
+            w.key("value");
+            w.value(e.value);
+            w.endObject();
+        }
+        w.key("pid");
+        w.value(pid);
+        w.key("tid");
+        w.value(qint64(e.threadId & 0x1FFFFFFFFFFFFFull));   // JSON numbers are doubles
+        w.endObject();
+    }
+    w.endArray();
+    w.endObject();
+
+    if (!w.finish() || !f.commit()) {
+        if (errorOut) *errorOut = QString("Could not write %1.").arg(path);
+        return false;
+    }
+    return true;
+}
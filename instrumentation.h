@@ -0,0 +1,90 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+#include <atomic>
+
+/*
+ * Instrumentation (Singleton) - in-process timing for latency hunting
+ *
+ *  - ScopedTimer measures the enclosing scope on the monotonic clock in
+ *    nanoseconds; counter() samples a value. Both land in a fixed-size ring
+ *    buffer that keeps the most recent events, so recording never allocates.
+ *  - Names and categories must be string literals (or otherwise outlive the
+ *    buffer); only the pointer is stored.
+ *  - exportChromeTrace() writes the buffer as Chrome trace-event JSON, which
+ *    chrome://tracing and Perfetto open directly.
+ *  - When disabled, a ScopedTimer costs one atomic load.
+ */
+
+struct TraceEvent
+{
+    const char *name = nullptr;
+    const char *category = nullptr;
+    qint64 startNs = 0;         // since the instrumentation clock started
+    qint64 durationNs = -1;     // -1 for a counter sample
+    qint64 value = 0;           // counter value
+    quint64 threadId = 0;
+};
+
+class Instrumentation
+{
+public:
+    static Instrumentation& instance();
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return m_enabled.load(std::memory_order_relaxed); }
+    void setCapacity(int events);   // clears the buffer
+
+    qint64 now() const { return m_clock.nsecsElapsed(); }
+    void record(const char *name, const char *category, qint64 startNs, qint64 durationNs);
+    void counter(const char *name, qint64 value, const char *category = "counter");
+
+    QVector<TraceEvent> events() const;   // oldest first
+    qint64 droppedEvents() const;         // overwritten since the last clear()
+    void clear();
+
+    bool exportChromeTrace(const QString &path, QString *errorOut = nullptr) const;
+
+private:
+    Instrumentation();
+    Instrumentation(const Instrumentation&) = delete;
+    Instrumentation& operator=(const Instrumentation&) = delete;
+
+    void push(const TraceEvent &e);
+
+    QElapsedTimer m_clock;
+    std::atomic<bool> m_enabled{true};
+    mutable QMutex m_mutex;
+    QVector<TraceEvent> m_ring;
+    qint64 m_written = 0;       // events ever pushed since the last clear()
+};
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(const char *name, const char *category = "app")
+        : m_name(name)
+        , m_category(category)
+        , m_start(Instrumentation::instance().isEnabled() ? Instrumentation::instance().now() : -1)
+    {
+    }
+    ~ScopedTimer()
+    {
+        if (m_start < 0) return;
+        Instrumentation &in = Instrumentation::instance();
+        in.record(m_name, m_category, m_start, in.now() - m_start);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+    const char *m_name;
+    const char *m_category;
+    qint64 m_start;
+};
+
+#endif // INSTRUMENTATION_H
@@ -0,0 +1,260 @@
+#include "jsonstreamreader.h"
+
+JsonStreamReader::JsonStreamReader(QIODevice *device, int bufferSize)
+    : m_device(device), m_bufferSize(qMax(bufferSize, 16))
+{
+    m_buffer.resize(m_bufferSize);
+}
+
+// Refills the buffer once it's used up; false at end of input
+bool JsonStreamReader::fill()
+{
+    if (m_pos < m_len) return true;
+
+    m_consumed += m_len;
+    m_pos = 0;
+    m_len = 0;
+    const qint64 n = m_device->read(m_buffer.data(), m_bufferSize);
+    if (n <= 0) return false;
+    m_len = int(n);
+    return true;
+}
+
+int JsonStreamReader::peek()
+{
+    if (!fill()) return -1;
+    return uchar(m_buffer.constData()[m_pos]);
+}
+
+int JsonStreamReader::get()
+{
+    if (!fill()) return -1;
+    return uchar(m_buffer.constData()[m_pos++]);
+}
+
+JsonStreamReader::Token JsonStreamReader::fail(const QString &message)
+{
+    if (m_error.isEmpty()) m_error = QString("%1 (at byte %2)").arg(message).arg(bytesConsumed());
+    return Error;
+}
+
+// A value finished; inside an object the next string is a key again
+void JsonStreamReader::valueDone()
+{
+    if (!m_stack.isEmpty() && m_stack.last().isObject) m_stack.last().keyNext = true;
+}
+
+JsonStreamReader::Token JsonStreamReader::next()
+{
+    if (!m_error.isEmpty()) return Error;
+
+    for (;;) {
+        const int c = get();
+        switch (c) {
+        case -1:
+            if (!m_stack.isEmpty()) return fail("Unexpected end of file.");
+            return EndOfDocument;
+        case ' ': case '\t': case '\n': case '\r': case ',': case ':':
+            continue;
+        case '{':
+            m_stack.append({ true, true });
+            return BeginObject;
+        case '[':
+            m_stack.append({ false, false });
+            return BeginArray;
+        case '}':
+        case ']':
+            if (m_stack.isEmpty() || m_stack.last().isObject != (c == '}')) return fail("Mismatched bracket.");
+            m_stack.removeLast();
+            valueDone();
+            return c == '}' ? EndObject : EndArray;
+        case '"':
+            if (!readString()) return Error;
+            if (!m_stack.isEmpty() && m_stack.last().isObject && m_stack.last().keyNext) {
+                m_stack.last().keyNext = false;
+                return Key;
+            }
+            valueDone();
+            return String;
+        case 't':
+            if (!readLiteral("rue")) return Error;
+            m_bool = true;
+            valueDone();
+            return Bool;
+        case 'f':
+            if (!readLiteral("alse")) return Error;
+            m_bool = false;
+            valueDone();
+            return Bool;
+        case 'n':
+            if (!readLiteral("ull")) return Error;
+            valueDone();
+            return Null;
+        default:
+            if (c == '-' || (c >= '0' && c <= '9')) {
+                if (!readNumber(c)) return Error;
+                valueDone();
+                return Number;
+            }
+            return fail(QString("Unexpected character '%1'.").arg(QLatin1Char(char(c))));
+        }
+    }
+}
+
+bool JsonStreamReader::skipValue(Token first)
+{
+    Token t = first == None ? next() : first;
+    if (t == Error || t == EndOfDocument) return false;
+    if (t != BeginObject && t != BeginArray) return true;
+
+    int depth = 1;
+    while (depth > 0) {
+        t = next();
+        if (t == BeginObject || t == BeginArray) ++depth;
+        else if (t == EndObject || t == EndArray) --depth;
+        else if (t == Error || t == EndOfDocument) return false;
+    }
+    return true;
+}
+
+static void appendUtf8(QByteArray &out, uint cp)
+{
+    if (cp < 0x80) {
+        out.append(char(cp));
+    } else if (cp < 0x800) {
+        out.append(char(0xC0 | (cp >> 6)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.append(char(0xE0 | (cp >> 12)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (cp >> 18)));
+        out.append(char(0x80 | ((cp >> 12) & 0x3F)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    }
+}
+
+// Reads up to the closing quote. Plain runs are copied straight out of the buffer;
+// only escapes go through the slow path. Converted to QString once at the end.
+bool JsonStreamReader::readString()
+{
+    m_scratch.clear();
+    m_pendingHigh = 0;
+
+    for (;;) {
+        if (!fill()) {
+            fail("Unterminated string.");
+            return false;
+        }
+
+        const char *p = m_buffer.constData() + m_pos;
+        const char *end = m_buffer.constData() + m_len;
+        const char *q = p;
+        while (q < end && *q != '"' && *q != '\\') ++q;
+        if (q != p) {
+            flushPendingSurrogate();
+            m_scratch.append(p, int(q - p));
+            m_pos += int(q - p);
+        }
+        if (q == end) continue;
+
+        if (get() == '"') break;
+        if (!readEscape()) return false;
+    }
+
+    flushPendingSurrogate();
+    m_string = QString::fromUtf8(m_scratch);
+    return true;
+}
+
+void JsonStreamReader::flushPendingSurrogate()
+{
+    if (!m_pendingHigh) return;
+    appendUtf8(m_scratch, 0xFFFD);
+    m_pendingHigh = 0;
+}
+
+bool JsonStreamReader::readHex4(uint &out)
+{
+    out = 0;
+    for (int i = 0; i < 4; ++i) {
+        const int c = get();
+        int v;
+        if (c >= '0' && c <= '9') v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else return false;
+        out = (out << 4) | uint(v);
+    }
+    return true;
+}
+
+bool JsonStreamReader::readEscape()
+{
+    const int c = get();
+    if (c != 'u') flushPendingSurrogate();
+
+    switch (c) {
+    case '"': case '\\': case '/':
+        m_scratch.append(char(c));
+        return true;
+    case 'b': m_scratch.append('\b'); return true;
+    case 'f': m_scratch.append('\f'); return true;
+    case 'n': m_scratch.append('\n'); return true;
+    case 'r': m_scratch.append('\r'); return true;
+    case 't': m_scratch.append('\t'); return true;
+    case 'u': break;
+    default:
+        fail("Invalid escape sequence.");
+        return false;
+    }
+
+    uint unit = 0;
+    if (!readHex4(unit)) {
+        fail("Invalid \\u escape.");
+        return false;
+    }
+
+    // Surrogate pairs arrive as two escapes; unpaired halves become U+FFFD
+    if (unit >= 0xDC00 && unit <= 0xDFFF && m_pendingHigh) {
+        appendUtf8(m_scratch, 0x10000 + ((m_pendingHigh - 0xD800) << 10) + (unit - 0xDC00));
+        m_pendingHigh = 0;
+        return true;
+    }
+    flushPendingSurrogate();
+    if (unit >= 0xD800 && unit <= 0xDBFF) m_pendingHigh = unit;
+    else if (unit >= 0xDC00 && unit <= 0xDFFF) appendUtf8(m_scratch, 0xFFFD);
+    else appendUtf8(m_scratch, unit);
+    return true;
+}
+
+bool JsonStreamReader::readLiteral(const char *rest)
+{
+    for (const char *p = rest; *p; ++p) {
+        if (get() != uchar(*p)) {
+            fail("Invalid literal.");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool JsonStreamReader::readNumber(int first)
+{
+    QByteArray num(1, char(first));
+    for (;;) {
+        const int c = peek();
+        if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+            num.append(char(get()));
+        } else {
+            break;
+        }
+    }
+
+    bool ok = false;
+    m_number = num.toDouble(&ok);
+    if (!ok) fail("Invalid number.");
+    return ok;
+}
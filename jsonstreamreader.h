@@ -0,0 +1,83 @@
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+/*
+ * JsonStreamReader (pull tokenizer over a QIODevice)
+ *
+ *  - Reads the device in fixed-size chunks, so memory is bounded by the buffer
+ *    size plus the longest single string in the document.
+ *  - next() returns one token at a time; commas and colons are consumed
+ *    internally and strings in key position come back as Key.
+ *  - skipValue() discards a whole value, including nested objects/arrays.
+ */
+
+class JsonStreamReader
+{
+public:
+    enum Token {
+        None,
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        Bool,
+        Null,
+        EndOfDocument,
+        Error
+    };
+
+    explicit JsonStreamReader(QIODevice *device, int bufferSize = 64 * 1024);
+
+    Token next();
+    bool skipValue(Token first = None);   // pass the token already read, if any
+
+    QString stringValue() const { return m_string; }
+    double numberValue() const { return m_number; }
+    bool boolValue() const { return m_bool; }
+
+    QString errorString() const { return m_error; }
+    qint64 bytesConsumed() const { return m_consumed + m_pos; }
+
+private:
+    struct Level {
+        bool isObject;
+        bool keyNext;
+    };
+
+    int peek();
+    int get();
+    bool fill();
+    Token fail(const QString &message);
+    void valueDone();
+    bool readString();
+    bool readEscape();
+    bool readHex4(uint &out);
+    void flushPendingSurrogate();
+    bool readLiteral(const char *rest);
+    bool readNumber(int first);
+
+    QIODevice *m_device;
+    QByteArray m_buffer;
+    int m_bufferSize;
+    int m_pos = 0;
+    int m_len = 0;
+    qint64 m_consumed = 0;   // bytes in buffers already fully consumed
+
+    QVector<Level> m_stack;
+    QByteArray m_scratch;    // UTF-8 bytes of the string being read
+    uint m_pendingHigh = 0;  // high surrogate waiting for its low half
+    QString m_string;
+    double m_number = 0;
+    bool m_bool = false;
+    QString m_error;
+};
+
+#endif // JSONSTREAMREADER_H
@@ -0,0 +1,151 @@
+#include "jsonstreamwriter.h"
+
+#include <cstdio>
+
+JsonStreamWriter::JsonStreamWriter(QIODevice *device, bool indented, int chunkSize)
+    : m_device(device), m_indented(indented), m_chunkSize(qMax(chunkSize, 256))
+{
+    m_out.reserve(m_chunkSize + 1024);
+}
+
+void JsonStreamWriter::newline()
+{
+    if (!m_indented) return;
+    m_out.append('\n');
+    m_out.append(QByteArray(4 * m_stack.size(), ' '));
+}
+
+// Separator and indentation for a value in an array; values after a key need neither
+void JsonStreamWriter::beforeValue()
+{
+    if (m_afterKey) {
+        m_afterKey = false;
+        return;
+    }
+    if (m_stack.isEmpty()) return;
+
+    Level &top = m_stack.last();
+    if (top.count++ > 0) m_out.append(',');
+    newline();
+}
+
+void JsonStreamWriter::beginObject()
+{
+    beforeValue();
+    m_out.append('{');
+    m_stack.append({ true, 0 });
+}
+
+void JsonStreamWriter::endObject()
+{
+    const bool empty = m_stack.last().count == 0;
+    m_stack.removeLast();
+    if (!empty) newline();
+    m_out.append('}');
+    maybeFlush();
+}
+
+void JsonStreamWriter::beginArray()
+{
+    beforeValue();
+    m_out.append('[');
+    m_stack.append({ false, 0 });
+}
+
+void JsonStreamWriter::endArray()
+{
+    const bool empty = m_stack.last().count == 0;
+    m_stack.removeLast();
+    if (!empty) newline();
+    m_out.append(']');
+    maybeFlush();
+}
+
+void JsonStreamWriter::key(const QString &name)
+{
+    Level &top = m_stack.last();
+    if (top.count++ > 0) m_out.append(',');
+    newline();
+    writeString(name);
+    m_out.append(m_indented ? ": " : ":");
+    m_afterKey = true;
+}
+
+void JsonStreamWriter::value(const QString &s)
+{
+    beforeValue();
+    writeString(s);
+    maybeFlush();
+}
+
+void JsonStreamWriter::value(qint64 v)
+{
+    beforeValue();
+    m_out.append(QByteArray::number(v));
+}
+
+void JsonStreamWriter::value(double v)
+{
+    beforeValue();
+    m_out.append(QByteArray::number(v, 'g', 17));
+}
+
+void JsonStreamWriter::value(bool v)
+{
+    beforeValue();
+    m_out.append(v ? "true" : "false");
+}
+
+// Copies runs that need no escaping in one go
+void JsonStreamWriter::writeString(const QString &s)
+{
+    const QByteArray utf8 = s.toUtf8();
+    const char *p = utf8.constData();
+    const char *end = p + utf8.size();
+    const char *run = p;
+
+    m_out.append('"');
+    for (; p < end; ++p) {
+        const uchar c = uchar(*p);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+        m_out.append(run, int(p - run));
+        switch (c) {
+        case '"': m_out.append("\\\""); break;
+        case '\\': m_out.append("\\\\"); break;
+        case '\b': m_out.append("\\b"); break;
+        case '\f': m_out.append("\\f"); break;
+        case '\n': m_out.append("\\n"); break;
+        case '\r': m_out.append("\\r"); break;
+        case '\t': m_out.append("\\t"); break;
+        default: {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", unsigned(c));
+            m_out.append(buf);
+        }
+        }
+        run = p + 1;
+    }
+    m_out.append(run, int(end - run));
+    m_out.append('"');
+}
+
+void JsonStreamWriter::maybeFlush()
+{
+    if (m_out.size() >= m_chunkSize) flushChunk();
+}
+
+bool JsonStreamWriter::flushChunk()
+{
+    if (m_out.isEmpty()) return m_ok;
+    if (m_device->write(m_out) != m_out.size()) m_ok = false;
+    m_written += m_out.size();
+    m_out.resize(0);   // keeps the reserved capacity
+    return m_ok;
+}
+
+bool JsonStreamWriter::finish()
+{
+    if (m_indented) m_out.append('\n');
+    return flushChunk();
+}
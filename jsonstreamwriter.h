@@ -0,0 +1,65 @@
+#ifndef JSONSTREAMWRITER_H
+#define JSONSTREAMWRITER_H
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QString>
+#include <QVector>
+
+/*
+ * JsonStreamWriter (push writer onto a QIODevice)
+ *
+ *  - Emits JSON as it is produced and hands it to the device in chunks, so
+ *    nothing close to the size of the document is ever held in memory.
+ *  - Indented output uses the layout of QJsonDocument::Indented (4 spaces, one
+ *    member per line); compact output has no whitespace at all. Neither is
+ *    byte-for-byte what QJsonDocument writes: keys come out in the order they
+ *    are written rather than sorted, and empty objects and arrays are always
+ *    {} and [] on one line. Both parse back to the same document.
+ *  - Call finish() at the end to flush the last chunk; it reports write errors.
+ */
+
+class JsonStreamWriter
+{
+public:
+    explicit JsonStreamWriter(QIODevice *device, bool indented = true, int chunkSize = 64 * 1024);
+
+    void beginObject();
+    void endObject();
+    void beginArray();
+    void endArray();
+
+    void key(const QString &name);
+    void value(const QString &s);
+    void value(const char *s) { value(QString::fromUtf8(s)); }
+    void value(int v) { value(qint64(v)); }
+    void value(qint64 v);
+    void value(double v);
+    void value(bool v);
+
+    bool finish();
+    qint64 bytesWritten() const { return m_written + m_out.size(); }
+
+private:
+    struct Level {
+        bool isObject;
+        int count;
+    };
+
+    void beforeValue();
+    void newline();
+    void writeString(const QString &s);
+    void maybeFlush();
+    bool flushChunk();
+
+    QIODevice *m_device;
+    bool m_indented;
+    int m_chunkSize;
+    QByteArray m_out;
+    qint64 m_written = 0;
+    bool m_ok = true;
+    bool m_afterKey = false;
+    QVector<Level> m_stack;
+};
+
+#endif // JSONSTREAMWRITER_H
@@ -4,13 +4,36 @@
 #include "deck.h"
 #include "deckwindow.h"
 #include "flashcardmanager.h"
+#include "instrumentation.h"
 #include "statstracker.h"
+#include "statswindow.h"
+#include "studywindow.h"
 
+#include <QDialogButtonBox>
 #include <QInputDialog>
+#include <QLabel>
+#include <QListWidget>
+#include <QVBoxLayout>
 #include <QMessageBox>
 #include <QFileDialog>
+#include <QDir>
+#include <QFileInfo>
 #include <QMenuBar>
 #include <QAction>
+#include <QEventLoop>
+#include <QProgressDialog>
+#include <QSettings>
+#include <QThread>
+#include <QTimer>
+#include <atomic>
+
+static const QString ImportFilters = "Deck Files (*.json *.csv *.tsv *.tab *.fcbz);;JSON Files (*.json);;"
+                                     "CSV/TSV Files (*.csv *.tsv *.tab);;Deck Bundles (*.fcbz)";
+static const QString CompactExportFilter = "Compact JSON Files (*.json)";
+static const QString BundleExportFilter = "Deck Bundles (*.fcbz)";
+static const QString ExportFilters = "JSON Files (*.json);;" + CompactExportFilter + ";;" + BundleExportFilter;
+static const QString PatchFilter = "Deck Updates (*.fcpatch)";
+static const QString BinaryStoreFilter = "Binary Deck Stores (*.fcdb)";
 
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
@@ -21,6 +44,11 @@ MainWindow::MainWindow(QWidget *parent)
     // Ensure manager is loaded from disk early
     (void)flashcardManager::instance();
 
+    // Storage tuning chosen in the Storage menu
+    QSettings storageSettings("MyFlashcardApp", "Storage");
+    flashcardManager::instance().setArenaThreshold(storageSettings.value("arenaThreshold", 0).toInt());
+    flashcardManager::instance().setInterningEnabled(storageSettings.value("interning", true).toBool());
+
     setupDeckButtons();
 
     // Create/delete buttons
@@ -48,14 +76,49 @@ MainWindow::MainWindow(QWidget *parent)
     connect(ui->exportDeckButton, &QPushButton::clicked, this, &MainWindow::onExportDeckClicked);
     connect(ui->exportAllButton, &QPushButton::clicked, this, &MainWindow::onExportAllDecksClicked);
 
+    QMenu *fileMenu = menuBar()->addMenu("File");
+    QAction *importFolderAction = fileMenu->addAction("Import Folder...");
+    connect(importFolderAction, &QAction::triggered, this, &MainWindow::onImportFolderClicked);
+    QAction *exportPatchAction = fileMenu->addAction("Export Deck Update...");
+    connect(exportPatchAction, &QAction::triggered, this, &MainWindow::onExportPatchClicked);
+    QAction *applyPatchAction = fileMenu->addAction("Apply Deck Update...");
+    connect(applyPatchAction, &QAction::triggered, this, &MainWindow::onApplyPatchClicked);
+    fileMenu->addSeparator();
+    QAction *searchAction = fileMenu->addAction("Search Cards...");
+    searchAction->setShortcut(QKeySequence::Find);
+    connect(searchAction, &QAction::triggered, this, &MainWindow::onSearchCardsClicked);
+    QAction *duplicatesAction = fileMenu->addAction("Find Duplicate Cards...");
+    connect(duplicatesAction, &QAction::triggered, this, &MainWindow::onFindDuplicatesClicked);
+    QAction *studyDueAction = fileMenu->addAction("Study Due Cards");
+    connect(studyDueAction, &QAction::triggered, this, &MainWindow::onStudyDueClicked);
+    fileMenu->addSeparator();
+    QAction *exportTraceAction = fileMenu->addAction("Export Performance Trace...");
+    connect(exportTraceAction, &QAction::triggered, this, &MainWindow::onExportTraceClicked);
+
+    QMenu *storageMenu = menuBar()->addMenu("Storage");
+    QAction *arenaAction = storageMenu->addAction("Large Deck Threshold...");
+    connect(arenaAction, &QAction::triggered, this, &MainWindow::onArenaThresholdClicked);
+    QAction *internAction = storageMenu->addAction("Share Identical Card Text");
+    internAction->setCheckable(true);
+    internAction->setChecked(flashcardManager::instance().isInterningEnabled());
+    connect(internAction, &QAction::toggled, this, &MainWindow::onInterningToggled);
+    QAction *memoryAction = storageMenu->addAction("Text Sharing Statistics...");
+    connect(memoryAction, &QAction::triggered, this, &MainWindow::onInternStatsClicked);
+    storageMenu->addSeparator();
+    QAction *toBinaryAction = storageMenu->addAction("Convert JSON Library to Binary...");
+    connect(toBinaryAction, &QAction::triggered, this, &MainWindow::onConvertToBinaryClicked);
+    QAction *toJsonAction = storageMenu->addAction("Convert Binary Library to JSON...");
+    connect(toJsonAction, &QAction::triggered, this, &MainWindow::onConvertToJsonClicked);
+    QAction *compareAction = storageMenu->addAction("Compare JSON and Binary Load Times...");
+    connect(compareAction, &QAction::triggered, this, &MainWindow::onCompareLoadPathsClicked);
 
     refreshDeckButtons();
 }
 
 MainWindow::~MainWindow()
 {
-    // Ensure last state is saved (in case any in-place edits happened without explicit save).
-    flashcardManager::instance().saveToDisk(nullptr);
+    // Edits are journaled as they happen; wait for any pending background write to land.
+    flashcardManager::instance().flush(nullptr);
 
     delete ui;
 }
@@ -71,15 +134,17 @@ void MainWindow::setupDeckButtons()
 
 QStringList MainWindow::getFilteredDeckNames() const
 {
-    QStringList names = flashcardManager::instance().getDeckNames();
-    if (currentTagFilter.trimmed().isEmpty()) return names;
-
-    QStringList filtered;
-    for (const QString& name : names) {
-        const deck* d = flashcardManager::instance().getDeck(name);
-        if (d && d->getTag() == currentTagFilter) filtered.append(name);
-    }
-    return filtered;
+    flashcardManager& mgr = flashcardManager::instance();
+    const quint64 version = mgr.deckListVersion();
+    if (m_filteredValid && m_filteredVersion == version && m_filteredFor == currentTagFilter) return m_filteredNames;
+
+    // The manager's tag index answers the query without visiting every deck
+    m_filteredNames = currentTagFilter.trimmed().isEmpty() ? mgr.getDeckNames()
+                                                           : mgr.findDecksByTags(currentTagFilter);
+    m_filteredFor = currentTagFilter;
+    m_filteredVersion = version;
+    m_filteredValid = true;
+    return m_filteredNames;
 }
 
 int MainWindow::totalPages() const
@@ -156,7 +221,7 @@ void MainWindow::onCreateDeckClicked()
         return;
     }
 
-    QString tag = QInputDialog::getText(this, "Create Deck", "Tag (optional):", QLineEdit::Normal, "", &ok);
+    QString tag = QInputDialog::getText(this, "Create Deck", "Tags, comma-separated (optional):", QLineEdit::Normal, "", &ok);
     if (!ok) return;
     tag = tag.trimmed();
 
@@ -211,15 +276,11 @@ void MainWindow::onRenameDeckClicked()
 
     if (newName == deckToRename) return;
 
-    // Rename = remove old key + reinsert deck under new key
-    deck *d = flashcardManager::instance().getDeck(deckToRename);
-    if (!d) return;
-
-    deck copy = *d;
-    copy.setName(newName);
-
-    flashcardManager::instance().removeDeck(deckToRename);
-    flashcardManager::instance().addDeck(copy);
+    QString err;
+    if (!flashcardManager::instance().renameDeck(deckToRename, newName, &err)) {
+        QMessageBox::warning(this, "Rename Failed", err);
+        return;
+    }
 
     refreshDeckButtons();
     QMessageBox::information(this, "Renamed", "Deck renamed successfully.");
@@ -228,9 +289,17 @@ void MainWindow::onRenameDeckClicked()
 void MainWindow::onFilterDeckClicked()
 {
     bool ok = false;
-    QString tag = QInputDialog::getText(this, "Filter Decks", "Enter tag to filter (leave empty to clear):", QLineEdit::Normal, currentTagFilter, &ok);
+    QString tag = QInputDialog::getText(this, "Filter Decks",
+                                        "Enter tags to filter, e.g. spanish AND NOT verbs (leave empty to clear):",
+                                        QLineEdit::Normal, currentTagFilter, &ok);
     if (!ok) return;
 
+    QString err;
+    if (!tag.trimmed().isEmpty() && !TagQuery::parse(tag, &err).isValid()) {
+        QMessageBox::warning(this, "Invalid Filter", err);
+        return;
+    }
+
     currentTagFilter = tag.trimmed();
     currentPage = 0;
     refreshDeckButtons();
@@ -238,32 +307,392 @@ void MainWindow::onFilterDeckClicked()
 
 void MainWindow::onViewStatsClicked()
 {
-    StatsTracker& tracker = StatsTracker::instance();
+    StatsWindow *w = new StatsWindow(this);
+    w->setAttribute(Qt::WA_DeleteOnClose);
+    w->show();
+}
+
+void MainWindow::onSearchCardsClicked()
+{
+    bool ok = false;
+    const QString query = QInputDialog::getText(this, "Search Cards",
+                                                "Words to find (prefixes match; start with * to match inside words):",
+                                                QLineEdit::Normal, QString(), &ok).trimmed();
+    if (!ok || query.isEmpty()) return;
+
+    const bool substring = query.startsWith('*');
+    const QVector<SearchHit> hits = flashcardManager::instance().searchCards(
+        substring ? query.mid(1) : query, substring ? SearchIndex::Match::Substring : SearchIndex::Match::Prefix);
+    if (hits.isEmpty()) {
+        QMessageBox::information(this, "Search Cards", "No cards match.");
+        return;
+    }
+
+    QStringList items;
+    items.reserve(hits.size());
+    for (const SearchHit& h : hits) {
+        const deck *d = flashcardManager::instance().getDeck(h.deckName);
+        const flashcard *fc = d ? d->findCard(h.cardId) : nullptr;
+        items.append(QString("%1: %2").arg(h.deckName, fc ? fc->getQuestion() : QString()));
+    }
+
+    // Labels can repeat (same question in one deck), so the pick is taken by row
+    QDialog picker(this);
+    picker.setWindowTitle("Search Cards");
+    auto *layout = new QVBoxLayout(&picker);
+    layout->addWidget(new QLabel(QString("%1 matching cards:").arg(hits.size()), &picker));
+    auto *list = new QListWidget(&picker);
+    list->addItems(items);
+    list->setCurrentRow(0);
+    layout->addWidget(list);
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Open | QDialogButtonBox::Cancel, &picker);
+    layout->addWidget(buttons);
+    connect(buttons, &QDialogButtonBox::accepted, &picker, &QDialog::accept);
+    connect(buttons, &QDialogButtonBox::rejected, &picker, &QDialog::reject);
+    connect(list, &QListWidget::itemActivated, &picker, &QDialog::accept);
+    if (picker.exec() != QDialog::Accepted) return;
+
+    const int row = list->currentRow();
+    if (row < 0 || row >= hits.size()) return;
+    const SearchHit& hit = hits[row];
+    deck *d = flashcardManager::instance().getDeck(hit.deckName);
+    if (!d) return;
+
+    DeckWindow *w = new DeckWindow(d, this);
+    w->selectCard(hit.cardId);
+    w->show();
+}
+
+// Recent timings as Chrome trace-event JSON (open in chrome://tracing or Perfetto)
+void MainWindow::onExportTraceClicked()
+{
+    const QString path = QFileDialog::getSaveFileName(this, "Export Performance Trace", "trace.json",
+                                                      "Trace Files (*.json)");
+    if (path.isEmpty()) return;
+
+    QString err;
+    if (!Instrumentation::instance().exportChromeTrace(path, &err)) {
+        QMessageBox::warning(this, "Export Failed", err);
+        return;
+    }
+    const qint64 dropped = Instrumentation::instance().droppedEvents();
+    QMessageBox::information(this, "Exported", dropped > 0
+        ? QString("Trace written. %1 older events had already been overwritten.").arg(dropped)
+        : QString("Trace written."));
+}
+
+// Decks with at least this many cards keep their text in one buffer (deck::Storage::Arena)
+void MainWindow::onArenaThresholdClicked()
+{
+    bool ok = false;
+    const int cards = QInputDialog::getInt(this, "Large Deck Threshold",
+                                           "Store decks with at least this many cards compactly (0 = never):",
+                                           flashcardManager::instance().arenaThreshold(), 0, 100000000, 1000, &ok);
+    if (!ok) return;
+
+    QSettings("MyFlashcardApp", "Storage").setValue("arenaThreshold", cards);
+    flashcardManager::instance().setArenaThreshold(cards);
+}
+
+void MainWindow::onInterningToggled(bool enabled)
+{
+    QSettings("MyFlashcardApp", "Storage").setValue("interning", enabled);
+    flashcardManager::instance().setInterningEnabled(enabled);
+}
+
+void MainWindow::onInternStatsClicked()
+{
+    flashcardManager& mgr = flashcardManager::instance();
+    if (!mgr.isInterningEnabled()) {
+        QMessageBox::information(this, "Text Sharing", "Sharing identical card text is turned off.");
+        return;
+    }
+
+    const StringPool::Stats s = mgr.internStats();
+    QMessageBox::information(this, "Text Sharing", QString(
+        "Distinct strings in the pool: %1 (%2 KB)\n"
+        "Duplicate text currently shared: %3 KB\n"
+        "Lookups since start: %4, answered from the pool: %5")
+        .arg(s.uniqueStrings).arg(s.poolBytes / 1024).arg(s.bytesSaved / 1024)
+        .arg(s.lookups).arg(s.hits));
+}
+
+void MainWindow::onConvertToBinaryClicked()
+{
+    const QString jsonPath = QFileDialog::getOpenFileName(this, "Convert JSON Library", QString(), "JSON Files (*.json)");
+    if (jsonPath.isEmpty()) return;
+    const QString binaryPath = QFileDialog::getSaveFileName(this, "Save Binary Library",
+                                                            QFileInfo(jsonPath).completeBaseName() + ".fcdb",
+                                                            BinaryStoreFilter);
+    if (binaryPath.isEmpty()) return;
+
+    QString err;
+    if (!flashcardManager::convertJsonToBinary(jsonPath, binaryPath, &err)) {
+        QMessageBox::warning(this, "Conversion Failed", err);
+        return;
+    }
+    QMessageBox::information(this, "Converted", "Binary library written.");
+}
+
+void MainWindow::onConvertToJsonClicked()
+{
+    const QString binaryPath = QFileDialog::getOpenFileName(this, "Convert Binary Library", QString(), BinaryStoreFilter);
+    if (binaryPath.isEmpty()) return;
+    const QString jsonPath = QFileDialog::getSaveFileName(this, "Save JSON Library",
+                                                          QFileInfo(binaryPath).completeBaseName() + ".json",
+                                                          "JSON Files (*.json)");
+    if (jsonPath.isEmpty()) return;
+
+    QString err;
+    if (!flashcardManager::convertBinaryToJson(binaryPath, jsonPath, &err)) {
+        QMessageBox::warning(this, "Conversion Failed", err);
+        return;
+    }
+    QMessageBox::information(this, "Converted", "JSON library written.");
+}
+
+// Both files should hold the same library, e.g. one converted from the other
+void MainWindow::onCompareLoadPathsClicked()
+{
+    const QString jsonPath = QFileDialog::getOpenFileName(this, "JSON Library", QString(), "JSON Files (*.json)");
+    if (jsonPath.isEmpty()) return;
+    const QString binaryPath = QFileDialog::getOpenFileName(this, "Binary Library", QFileInfo(jsonPath).absolutePath(),
+                                                            BinaryStoreFilter);
+    if (binaryPath.isEmpty()) return;
+
+    const StoreLoadComparison c = flashcardManager::compareLoadPaths(jsonPath, binaryPath);
+    if (c.decks == 0) {
+        QMessageBox::warning(this, "Compare Load Times", "The binary library could not be opened or is empty.");
+        return;
+    }
+    QMessageBox::information(this, "Compare Load Times", QString(
+        "%1 decks, %2 cards\n\n"
+        "JSON: %3 KB, loaded in %4 ms\n"
+        "Binary: %5 KB, opened in %6 ms, every card read in %7 ms, decks built in %8 ms")
+        .arg(c.decks).arg(c.cards)
+        .arg(c.jsonBytes / 1024).arg(c.jsonLoadMs)
+        .arg(c.binaryBytes / 1024).arg(c.binaryOpenMs).arg(c.binaryScanMs).arg(c.binaryMaterializeMs));
+}
+
+// Due cards from every deck, most overdue first
+void MainWindow::onStudyDueClicked()
+{
+    auto *w = new studywindow(nullptr, this, studywindow::Mode::Due);
+    w->setWindowFlag(Qt::Window);
+    w->setAttribute(Qt::WA_DeleteOnClose);
+    w->show();
+}
+
+void MainWindow::onFindDuplicatesClicked()
+{
+    QVector<DuplicateCluster> clusters;
+    DuplicateScanStats stats;
+    if (!runWithProgress("Looking for duplicate cards...", [&](const flashcardManager::ProgressCallback& progress) {
+            clusters = flashcardManager::instance().findDuplicateCards(0.8, &stats, progress);
+        })) {
+        return;
+    }
+
+    if (clusters.isEmpty()) {
+        QMessageBox::information(this, "Duplicate Cards",
+                                 QString("No duplicates among %1 cards.").arg(stats.cards));
+        return;
+    }
 
-    QString msg = QString("Total Decks: %1\nTotal Cards: %2\nTotal Reviews: %3\nCorrect: %4\nIncorrect: %5")
-        .arg(tracker.getTotalDecks())
-        .arg(tracker.getTotalCards())
-        .arg(tracker.getTotalReviews())
-        .arg(tracker.getTotalCorrect())
-        .arg(tracker.getTotalIncorrect());
+    QString msg = QString("Found %1 duplicate cards in %2 groups (%3 cards checked in %4 ms).\n")
+        .arg(stats.duplicates).arg(stats.clusters).arg(stats.cards).arg(stats.totalMs);
+    const int shown = qMin(clusters.size(), 10);
+    for (int i = 0; i < shown; ++i) {
+        QStringList decksInCluster;
+        for (const DuplicateCard& c : clusters[i].cards) decksInCluster.append(c.deckName);
+        msg += QString("\n%1 (%2% similar)").arg(decksInCluster.join(", ")).arg(int(clusters[i].similarity * 100));
+    }
+    if (clusters.size() > shown) msg += QString("\n...and %1 more groups").arg(clusters.size() - shown);
+    msg += "\n\nKeep the first card of each group, remove the others and delete decks left empty?";
+
+    if (QMessageBox::question(this, "Duplicate Cards", msg) != QMessageBox::Yes) return;
 
-    QMessageBox::information(this, "Statistics", msg);
+    const int removed = flashcardManager::instance().removeDuplicateCards(clusters);
+    refreshDeckButtons();
+    QMessageBox::information(this, "Duplicate Cards", QString("Removed %1 cards.").arg(removed));
+}
+
+// Runs task on a worker thread behind a modal progress dialog. The task gets a
+// progress callback that reports (done, total) and returns false once cancelled.
+// Returns false if the user cancelled.
+bool MainWindow::runWithProgress(const QString& label,
+                                 const std::function<void(const flashcardManager::ProgressCallback&)>& task)
+{
+    QProgressDialog progressDialog(label, "Cancel", 0, 1000, this);
+    progressDialog.setWindowModality(Qt::WindowModal);
+    progressDialog.setMinimumDuration(300);
+
+    std::atomic<qint64> done{0};
+    std::atomic<qint64> total{0};
+    std::atomic<bool> cancelled{false};
+
+    QThread *worker = QThread::create([&]() {
+        task([&](qint64 d, qint64 t) {
+            done = d;
+            total = t;
+            return !cancelled.load();
+        });
+    });
+
+    QEventLoop loop;
+    QTimer poll;
+    poll.setInterval(50);
+    connect(&poll, &QTimer::timeout, this, [&]() {
+        const qint64 t = total.load();
+        if (t > 0) progressDialog.setValue(int(done.load() * 1000 / t));
+    });
+    connect(&progressDialog, &QProgressDialog::canceled, this, [&]() { cancelled = true; });
+    connect(worker, &QThread::finished, &loop, &QEventLoop::quit);
+
+    worker->start();
+    poll.start();
+    loop.exec();
+    worker->wait();
+    delete worker;
+    progressDialog.reset();
+
+    return !cancelled.load();
 }
 
 void MainWindow::onImportDeckClicked()
 {
-    const QString filePath = QFileDialog::getOpenFileName(this, "Import Deck", QString(), "JSON Files (*.json)");
-    if (filePath.isEmpty()) return;
+    const QStringList filePaths = QFileDialog::getOpenFileNames(this, "Import Decks", QString(), ImportFilters);
+    if (filePaths.isEmpty()) return;
+    if (filePaths.size() > 1) {
+        importDecks(filePaths);
+        return;
+    }
+    const QString filePath = filePaths.first();
 
-    QString importedName;
+    // Parse on a worker thread so large files don't freeze the window
+    QVector<deck> parsed;
     QString err;
-    if (!flashcardManager::instance().importDeckFromFile(filePath, &importedName, &err)) {
-        QMessageBox::warning(this, "Import Failed", err.isEmpty() ? "Could not import deck." : err);
+    CsvImportStats csvStats;
+    bool ok = false;
+    const bool completed = runWithProgress("Importing deck...", [&](const flashcardManager::ProgressCallback& progress) {
+        ok = flashcardManager::readDecksFromFile(filePath, parsed, &err, progress, &csvStats);
+    });
+
+    if (!ok) {
+        if (completed) QMessageBox::warning(this, "Import Failed", err.isEmpty() ? "Could not import deck." : err);
+        return;
+    }
+
+    // Re-importing a deck we already have: offer to merge it instead of making a copy
+    bool exists = false;
+    for (const deck& d : parsed) exists = exists || flashcardManager::instance().hasDeck(d.getName().trimmed());
+    if (exists) {
+        QMessageBox box(QMessageBox::Question, "Import",
+                        "A deck with this name already exists. Merge the imported cards into it, "
+                        "or import a separate copy?", QMessageBox::Cancel, this);
+        QPushButton *mergeButton = box.addButton("Merge", QMessageBox::AcceptRole);
+        box.addButton("Import Copy", QMessageBox::AcceptRole);
+        box.exec();
+        if (box.clickedButton() == box.button(QMessageBox::Cancel)) return;
+
+        if (box.clickedButton() == mergeButton) {
+            const MergeImportSummary s = flashcardManager::instance().mergeImportedDecks(parsed);
+            refreshDeckButtons();
+            QMessageBox::information(this, "Merged",
+                                     QString("Added %1, updated %2, unchanged %3 cards.")
+                                         .arg(s.added).arg(s.updated).arg(s.unchanged));
+            return;
+        }
+    }
+
+    QStringList importedNames;
+    {
+        flashcardManager::Batch batch(flashcardManager::instance());
+        for (const deck& d : parsed) importedNames.append(flashcardManager::instance().addImportedDeck(d));
+    }
+    refreshDeckButtons();
+    QString msg = importedNames.size() == 1
+        ? QString("Imported deck: %1").arg(importedNames.first())
+        : QString("Imported %1 decks.").arg(importedNames.size());
+    if (csvStats.skippedRows > 0) msg += QString("\nSkipped %1 incomplete rows.").arg(csvStats.skippedRows);
+    QMessageBox::information(this, "Imported", msg);
+}
+
+void MainWindow::onImportFolderClicked()
+{
+    const QString dirPath = QFileDialog::getExistingDirectory(this, "Import Folder");
+    if (dirPath.isEmpty()) return;
+
+    const QStringList filters = QStringList() << "*.json" << "*.csv" << "*.tsv" << "*.tab" << "*.fcbz";
+    const QFileInfoList files = QDir(dirPath).entryInfoList(filters, QDir::Files, QDir::Name);
+    if (files.isEmpty()) {
+        QMessageBox::information(this, "Import Folder", "No deck files found in that folder.");
         return;
     }
 
+    QStringList filePaths;
+    for (const QFileInfo& fi : files) filePaths.append(fi.absoluteFilePath());
+    importDecks(filePaths);
+}
+
+void MainWindow::importDecks(const QStringList& filePaths)
+{
+    BulkImportResult result;
+    runWithProgress("Importing decks...", [&](const flashcardManager::ProgressCallback& progress) {
+        result = flashcardManager::instance().importDecksFromFiles(filePaths, progress);
+    });
+    if (result.cancelled) return;
+
     refreshDeckButtons();
-    QMessageBox::information(this, "Imported", QString("Imported deck: %1").arg(importedName));
+
+    QString msg = QString("Imported %1 of %2 decks.").arg(result.importedNames.size()).arg(filePaths.size());
+    if (!result.failedFiles.isEmpty()) {
+        msg += "\n\nFailed:";
+        const int shown = qMin(result.failedFiles.size(), 10);
+        for (int i = 0; i < shown; ++i) {
+            msg += QString("\n%1: %2").arg(QFileInfo(result.failedFiles[i]).fileName(), result.errors[i]);
+        }
+        if (result.failedFiles.size() > shown) {
+            msg += QString("\n...and %1 more").arg(result.failedFiles.size() - shown);
+        }
+        QMessageBox::warning(this, "Import", msg);
+        return;
+    }
+    QMessageBox::information(this, "Imported", msg);
+}
+
+// Copies the decks on the GUI thread, then streams them to disk on a worker thread.
+// The save dialog's filter picks indented JSON, compact JSON or a compressed bundle.
+bool MainWindow::exportDecks(const QStringList& names, const QString& filePath, const QString& filter,
+                             QString *errorOut, QString *summaryOut)
+{
+    const QVector<deck> snapshot = flashcardManager::instance().snapshotDecks(names);
+    if (snapshot.isEmpty() && !names.isEmpty()) {
+        if (errorOut) *errorOut = "Deck not found.";
+        return false;
+    }
+
+    const bool bundle = filter == BundleExportFilter || filePath.endsWith(".fcbz", Qt::CaseInsensitive);
+    DeckBundleStats stats;
+    bool ok = false;
+    const bool completed = runWithProgress("Exporting...", [&](const flashcardManager::ProgressCallback& progress) {
+        if (bundle) {
+            ok = flashcardManager::writeBundle(filePath, snapshot, errorOut, &stats, progress);
+        } else {
+            ok = flashcardManager::writeDecksStreaming(filePath, snapshot, !names.isEmpty(),
+                                                       filter == CompactExportFilter, errorOut, progress);
+        }
+    });
+    if (!completed && errorOut) errorOut->clear();
+
+    if (ok && bundle && summaryOut) {
+        *summaryOut = QString("\nCompressed %1 KB to %2 KB (%3x) at %4 MB/s.")
+            .arg(stats.rawBytes / 1024)
+            .arg(stats.compressedBytes / 1024)
+            .arg(stats.ratio(), 0, 'f', 1)
+            .arg(stats.megabytesPerSecond(), 0, 'f', 1);
+    }
+    return ok;
 }
 
 void MainWindow::onExportDeckClicked()
@@ -278,28 +707,86 @@ void MainWindow::onExportDeckClicked()
     QString deckName = QInputDialog::getItem(this, "Export Deck", "Select a deck:", names, 0, false, &ok);
     if (!ok) return;
 
-    const QString filePath = QFileDialog::getSaveFileName(this, "Export Deck", deckName + ".json", "JSON Files (*.json)");
+    QString filter;
+    const QString filePath = QFileDialog::getSaveFileName(this, "Export Deck", deckName + ".json",
+                                                          ExportFilters, &filter);
     if (filePath.isEmpty()) return;
 
     QString err;
-    if (!flashcardManager::instance().exportDeckToFile(deckName, filePath, &err)) {
-        QMessageBox::warning(this, "Export Failed", err.isEmpty() ? "Could not export deck." : err);
+    QString summary;
+    if (!exportDecks(QStringList() << deckName, filePath, filter, &err, &summary)) {
+        if (!err.isEmpty()) QMessageBox::warning(this, "Export Failed", err);
         return;
     }
 
-    QMessageBox::information(this, "Exported", "Deck exported successfully.");
+    QMessageBox::information(this, "Exported", "Deck exported successfully." + summary);
 }
 
 void MainWindow::onExportAllDecksClicked()
 {
-    const QString filePath = QFileDialog::getSaveFileName(this, "Export All Decks", "all_decks.json", "JSON Files (*.json)");
+    QString filter;
+    const QString filePath = QFileDialog::getSaveFileName(this, "Export All Decks", "all_decks.json",
+                                                          ExportFilters, &filter);
     if (filePath.isEmpty()) return;
 
     QString err;
-    if (!flashcardManager::instance().exportAllDecksToFile(filePath, &err)) {
-        QMessageBox::warning(this, "Export Failed", err.isEmpty() ? "Could not export decks." : err);
+    QString summary;
+    if (!exportDecks(QStringList(), filePath, filter, &err, &summary)) {
+        if (!err.isEmpty()) QMessageBox::warning(this, "Export Failed", err);
+        return;
+    }
+
+    QMessageBox::information(this, "Exported", "All decks exported successfully." + summary);
+}
+
+// Writes only what changed since an earlier export of the deck
+void MainWindow::onExportPatchClicked()
+{
+    QStringList names = flashcardManager::instance().getDeckNames();
+    if (names.isEmpty()) {
+        QMessageBox::information(this, "No Decks", "There are no decks to export.");
+        return;
+    }
+
+    bool ok = false;
+    const QString deckName = QInputDialog::getItem(this, "Export Deck Update", "Select a deck:", names, 0, false, &ok);
+    if (!ok) return;
+
+    const QString basePath = QFileDialog::getOpenFileName(this, "Previously Exported Version", QString(), ImportFilters);
+    if (basePath.isEmpty()) return;
+
+    const QString patchPath = QFileDialog::getSaveFileName(this, "Export Deck Update", deckName + ".fcpatch", PatchFilter);
+    if (patchPath.isEmpty()) return;
+
+    QString err;
+    DeckPatch patch;
+    if (!flashcardManager::instance().exportDeckPatch(deckName, basePath, patchPath, &err, &patch)) {
+        QMessageBox::warning(this, "Export Failed", err);
         return;
     }
 
-    QMessageBox::information(this, "Exported", "All decks exported successfully.");
+    QMessageBox::information(this, "Exported", QString("Update written: %1 added, %2 changed, %3 removed.")
+                                                   .arg(patch.count(DeckPatchRecord::Add))
+                                                   .arg(patch.count(DeckPatchRecord::Modify))
+                                                   .arg(patch.count(DeckPatchRecord::Delete)));
+}
+
+void MainWindow::onApplyPatchClicked()
+{
+    const QString patchPath = QFileDialog::getOpenFileName(this, "Apply Deck Update", QString(), PatchFilter);
+    if (patchPath.isEmpty()) return;
+
+    QString err;
+    DeckPatch patch;
+    if (!flashcardManager::instance().applyDeckPatchFile(patchPath, &err, &patch)) {
+        QMessageBox::warning(this, "Update Failed", err + "\n\nThe deck was not changed.");
+        return;
+    }
+
+    refreshDeckButtons();
+    QMessageBox::information(this, "Updated", QString("%1: %2 added, %3 changed, %4 removed.")
+                                                  .arg(patch.deckName)
+                                                  .arg(patch.count(DeckPatchRecord::Add))
+                                                  .arg(patch.count(DeckPatchRecord::Modify))
+                                                  .arg(patch.count(DeckPatchRecord::Delete)));
 }
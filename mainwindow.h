@@ -3,6 +3,8 @@
 
 #include <QMainWindow>
 #include <QPushButton>
+#include <functional>
+#include "flashcardmanager.h"
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -27,11 +29,24 @@ private slots:
     void onNextPageClicked();
     void onPrevPageClicked();
     void onViewStatsClicked();
+    void onSearchCardsClicked();
+    void onFindDuplicatesClicked();
+    void onStudyDueClicked();
+    void onExportTraceClicked();
+    void onArenaThresholdClicked();
+    void onInterningToggled(bool enabled);
+    void onInternStatsClicked();
+    void onConvertToBinaryClicked();
+    void onConvertToJsonClicked();
+    void onCompareLoadPathsClicked();
 
     // Import/Export (JSON)
     void onImportDeckClicked();
+    void onImportFolderClicked();
     void onExportDeckClicked();
     void onExportAllDecksClicked();
+    void onExportPatchClicked();
+    void onApplyPatchClicked();
 
 private:
     Ui::MainWindow *ui;
@@ -45,7 +60,19 @@ private:
     int totalPages() const;
     QStringList getFilteredDeckNames() const;
 
+    bool runWithProgress(const QString& label,
+                         const std::function<void(const flashcardManager::ProgressCallback&)>& task);
+    void importDecks(const QStringList& filePaths);
+    bool exportDecks(const QStringList& names, const QString& filePath, const QString& filter,
+                     QString *errorOut, QString *summaryOut);
+
     QString currentTagFilter = "";
+
+    // Filtered names, rebuilt only when the filter or the manager's deck list changes
+    mutable QStringList m_filteredNames;
+    mutable QString m_filteredFor;
+    mutable quint64 m_filteredVersion = 0;
+    mutable bool m_filteredValid = false;
 };
 
 #endif // MAINWINDOW_H
@@ -0,0 +1,101 @@
+#include "persistenceworker.h"
+
+#include <QMutexLocker>
+
+PersistenceWorker::PersistenceWorker(SaveFunction save, QObject *parent)
+    : QThread(parent), m_save(std::move(save))
+{
+    m_clock.start();
+}
+
+PersistenceWorker::~PersistenceWorker()
+{
+    {
+        QMutexLocker lock(&m_mutex);
+        m_stop = true;
+        m_wake.wakeAll();
+    }
+    // run() writes anything still dirty before it returns
+    wait();
+}
+
+void PersistenceWorker::setDebounceInterval(int ms)
+{
+    QMutexLocker lock(&m_mutex);
+    m_debounceMs = ms;
+}
+
+void PersistenceWorker::markDirty()
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_stop) return;
+    if (!isRunning()) start(QThread::LowPriority);
+
+    m_dirty = true;
+    m_lastDirtyAt = m_clock.elapsed();
+    ++m_stats.pendingRequests;
+    m_wake.wakeAll();
+}
+
+bool PersistenceWorker::flush(QString *errorOut)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_dirty || m_writing) {
+        m_flushRequested = true;
+        m_wake.wakeAll();
+        while (m_dirty || m_writing) m_idle.wait(&m_mutex);
+    }
+
+    if (!m_lastOk && errorOut) *errorOut = m_lastError;
+    return m_lastOk;
+}
+
+PersistenceWorker::Stats PersistenceWorker::stats() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_stats;
+}
+
+void PersistenceWorker::run()
+{
+    QMutexLocker lock(&m_mutex);
+    for (;;) {
+        while (!m_dirty && !m_stop) m_wake.wait(&m_mutex);
+        if (!m_dirty) break;
+
+        // Debounce: keep waiting while edits keep arriving
+        while (!m_flushRequested && !m_stop) {
+            const qint64 remaining = m_lastDirtyAt + m_debounceMs - m_clock.elapsed();
+            if (remaining <= 0) break;
+            m_wake.wait(&m_mutex, static_cast<unsigned long>(remaining));
+        }
+
+        m_dirty = false;
+        m_writing = true;
+        const int batch = m_stats.pendingRequests;
+        m_stats.pendingRequests = 0;
+        lock.unlock();
+
+        QString err;
+        QElapsedTimer timer;
+        timer.start();
+        const bool ok = m_save(&err);
+        const qint64 ms = timer.elapsed();
+
+        lock.relock();
+        m_writing = false;
+        m_lastOk = ok;
+        m_lastError = err;
+        m_stats.lastSaveMs = ms;
+        m_stats.totalSaveMs += ms;
+        if (ms > m_stats.maxSaveMs) m_stats.maxSaveMs = ms;
+        if (ok) ++m_stats.savesWritten; else ++m_stats.savesFailed;
+        if (batch > 1) m_stats.requestsCoalesced += batch - 1;
+
+        if (!m_dirty) {
+            m_flushRequested = false;
+            m_idle.wakeAll();
+        }
+    }
+    m_idle.wakeAll();
+}
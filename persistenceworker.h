@@ -0,0 +1,67 @@
+#ifndef PERSISTENCEWORKER_H
+#define PERSISTENCEWORKER_H
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QWaitCondition>
+#include <functional>
+
+/*
+ * PersistenceWorker (dedicated save thread)
+ *
+ *  - markDirty() is cheap and can be called on every mutation; the worker waits
+ *    until no new request arrived for the debounce interval, then runs the save
+ *    function once for the whole burst.
+ *  - The save function runs on the worker thread and is responsible for taking
+ *    its own consistent snapshot (see flashcardManager::writeSnapshotNow).
+ *  - flush() blocks until everything requested so far is on disk (use at shutdown).
+ */
+
+class PersistenceWorker : public QThread
+{
+public:
+    using SaveFunction = std::function<bool(QString *errorOut)>;
+
+    struct Stats {
+        qint64 lastSaveMs = 0;      // latency of the most recent write
+        qint64 maxSaveMs = 0;
+        qint64 totalSaveMs = 0;
+        int pendingRequests = 0;    // queue depth: requests waiting for the next write
+        int savesWritten = 0;
+        int savesFailed = 0;
+        int requestsCoalesced = 0;  // requests absorbed by a write for another request
+    };
+
+    explicit PersistenceWorker(SaveFunction save, QObject *parent = nullptr);
+    ~PersistenceWorker() override;
+
+    void setDebounceInterval(int ms);
+    void markDirty();
+    bool flush(QString *errorOut = nullptr);
+    Stats stats() const;
+
+protected:
+    void run() override;
+
+private:
+    SaveFunction m_save;
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_wake;
+    QWaitCondition m_idle;
+    QElapsedTimer m_clock;
+
+    qint64 m_lastDirtyAt = 0;
+    int m_debounceMs = 500;
+    bool m_dirty = false;
+    bool m_writing = false;
+    bool m_flushRequested = false;
+    bool m_stop = false;
+    bool m_lastOk = true;
+    QString m_lastError;
+    Stats m_stats;
+};
+
+#endif // PERSISTENCEWORKER_H
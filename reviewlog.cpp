@@ -0,0 +1,283 @@
+#include "reviewlog.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QSaveFile>
+#include <cstring>
+
+static const char Magic[4] = { 'F', 'C', 'R', 'L' };
+static const quint32 EndianMarker = 0x01020304;
+static const qint64 HeaderSize = 16;
+static const qint64 RecordSize = sizeof(ReviewRecord);
+static const qint64 V1RecordSize = 24;   // cardId, timestamp, latencyMs, grade, 3 reserved
+static const int MaxPendingRecords = 64 * 1024;   // held while the file can't be written
+
+static_assert(sizeof(ReviewRecord) == 32, "ReviewRecord is an on-disk layout");
+
+static quint32 readU32(const uchar *p)
+{
+    quint32 v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+quint64 ReviewRecord::keyOf(const QString &deckName)
+{
+    const QByteArray hash = QCryptographicHash::hash(deckName.toUtf8(), QCryptographicHash::Sha1);
+    quint64 key;
+    std::memcpy(&key, hash.constData(), sizeof(key));
+    return key ? key : 1;
+}
+
+static QByteArray header()
+{
+    QByteArray h(int(HeaderSize), '\0');
+    const quint32 fields[3] = { ReviewLogReader::Version, quint32(RecordSize), EndianMarker };
+    std::memcpy(h.data(), Magic, 4);
+    std::memcpy(h.data() + 4, fields, sizeof(fields));
+    return h;
+}
+
+static bool validHeader(const uchar *p, quint32 version = ReviewLogReader::Version, qint64 recordSize = RecordSize)
+{
+    return std::memcmp(p, Magic, 4) == 0 && readU32(p + 4) == version
+        && readU32(p + 8) == quint32(recordSize) && readU32(p + 12) == EndianMarker;
+}
+
+static bool isV1Header(const uchar *p)
+{
+    return validHeader(p, 1, V1RecordSize);
+}
+
+// Version 1 records are reviews without a deck key
+static void appendV1Records(const uchar *data, qint64 count, QVector<ReviewRecord> &out)
+{
+    out.reserve(out.size() + int(count));
+    for (qint64 i = 0; i < count; ++i) {
+        const uchar *p = data + i * V1RecordSize;
+        ReviewRecord r;
+        std::memcpy(&r.cardId, p, 8);
+        std::memcpy(&r.timestamp, p + 8, 8);
+        std::memcpy(&r.latencyMs, p + 16, 4);
+        r.grade = p[20];
+        out.append(r);
+    }
+}
+
+// ---------------------------------------------------------
+// ReviewLogWriter
+// ---------------------------------------------------------
+
+ReviewLogWriter::ReviewLogWriter(const QString &path, int bufferRecords)
+    : m_path(path)
+    , m_bufferRecords(qMax(1, bufferRecords))
+{
+    m_buffer.reserve(m_bufferRecords);
+}
+
+ReviewLogWriter::~ReviewLogWriter()
+{
+    flush(nullptr);
+}
+
+void ReviewLogWriter::setPath(const QString &path)
+{
+    QMutexLocker lock(&m_mutex);
+    if (path == m_path) return;
+    flushLocked(nullptr);
+    m_file.close();
+    m_path = path;
+}
+
+QString ReviewLogWriter::path() const
+{
+    QMutexLocker lock(&m_mutex);
+    return m_path;
+}
+
+bool ReviewLogWriter::append(const ReviewRecord &record, QString *errorOut)
+{
+    QMutexLocker lock(&m_mutex);
+    if (m_buffer.size() >= qMax(MaxPendingRecords, m_bufferRecords) && !flushLocked(errorOut)) {
+        // Unusable for a while now: drop the record rather than grow without bound
+        return false;
+    }
+    m_buffer.append(record);
+    if (m_buffer.size() % m_bufferRecords != 0) return true;   // retry a failing file once per batch
+    return flushLocked(errorOut);
+}
+
+bool ReviewLogWriter::flush(QString *errorOut)
+{
+    QMutexLocker lock(&m_mutex);
+    return flushLocked(errorOut);
+}
+
+// Opens the log for appending: writes the header of a new file, cuts a torn tail off an old one
+bool ReviewLogWriter::ensureOpen(QString *errorOut)
+{
+    if (m_file.isOpen()) return true;
+    if (m_path.isEmpty()) {
+        if (errorOut) *errorOut = "No review log path set.";
+        return false;
+    }
+
+    QDir().mkpath(QFileInfo(m_path).absolutePath());
+    m_file.setFileName(m_path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for writing.").arg(m_path);
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    if (size < HeaderSize) {
+        const QByteArray h = header();
+        if (!m_file.resize(0) || m_file.write(h) != h.size()) {
+            if (errorOut) *errorOut = QString("Could not write %1.").arg(m_path);
+            m_file.close();
+            return false;
+        }
+    } else {
+        const QByteArray h = m_file.read(HeaderSize);
+        const uchar *p = reinterpret_cast<const uchar *>(h.constData());
+        if (isV1Header(p)) return upgrade(errorOut);
+        if (!validHeader(p)) {
+            if (errorOut) *errorOut = QString("%1 is not a supported review log.").arg(m_path);
+            m_file.close();
+            return false;
+        }
+        const qint64 whole = HeaderSize + (size - HeaderSize) / RecordSize * RecordSize;
+        if (whole != size) m_file.resize(whole);
+    }
+    return m_file.seek(m_file.size());
+}
+
+// Rewrites the version 1 log open in m_file as version 2, then reopens it for appending
+bool ReviewLogWriter::upgrade(QString *errorOut)
+{
+    const QByteArray old = m_file.readAll();
+    m_file.close();
+
+    QVector<ReviewRecord> records;
+    appendV1Records(reinterpret_cast<const uchar *>(old.constData()), old.size() / V1RecordSize, records);
+
+    QSaveFile out(m_path);
+    const QByteArray h = header();
+    const qint64 bytes = records.size() * RecordSize;
+    if (!out.open(QIODevice::WriteOnly) || out.write(h) != h.size()
+        || out.write(reinterpret_cast<const char *>(records.constData()), bytes) != bytes || !out.commit()) {
+        if (errorOut) *errorOut = QString("Could not upgrade %1.").arg(m_path);
+        return false;
+    }
+    return ensureOpen(errorOut);
+}
+
+bool ReviewLogWriter::flushLocked(QString *errorOut)
+{
+    if (m_buffer.isEmpty()) return true;
+    if (!ensureOpen(errorOut)) return false;
+
+    const qint64 start = m_file.size();
+    const qint64 bytes = m_buffer.size() * RecordSize;
+    if (m_file.write(reinterpret_cast<const char *>(m_buffer.constData()), bytes) != bytes || !m_file.flush()) {
+        if (errorOut) *errorOut = QString("Could not write %1.").arg(m_path);
+        m_file.close();
+
+        // Whole records that reached the file stay there; only the rest is written again.
+        // Reopening cuts off a torn one.
+        const qint64 landed = qBound<qint64>(0, (QFileInfo(m_path).size() - start) / RecordSize, m_buffer.size());
+        m_buffer.remove(0, int(landed));
+        return false;
+    }
+    m_buffer.clear();
+    return true;
+}
+
+// ---------------------------------------------------------
+// ReviewLogReader
+// ---------------------------------------------------------
+
+ReviewLogReader::~ReviewLogReader()
+{
+    close();
+}
+
+bool ReviewLogReader::open(const QString &path, QString *errorOut)
+{
+    close();
+    if (!QFile::exists(path)) return true;
+
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for reading.").arg(path);
+        return false;
+    }
+
+    const qint64 size = m_file.size();
+    if (size < HeaderSize) {
+        close();
+        return true;   // created but nothing flushed yet
+    }
+
+    m_map = m_file.map(0, size);
+    const uchar *data = m_map;
+    QByteArray read;
+    if (!data) {
+        read = m_file.readAll();
+        data = reinterpret_cast<const uchar *>(read.constData());
+    }
+    if (isV1Header(data)) {
+        appendV1Records(data + HeaderSize, (size - HeaderSize) / V1RecordSize, m_fallback);
+        if (m_map) m_file.unmap(m_map);
+        m_map = nullptr;
+        m_count = m_fallback.size();
+        m_records = m_fallback.constData();
+        return true;
+    }
+    if (!validHeader(data)) {
+        if (errorOut) *errorOut = QString("%1 is not a supported review log.").arg(path);
+        close();
+        return false;
+    }
+
+    // A torn last record is ignored. The mapping is page aligned, so records can be used in place.
+    m_count = (size - HeaderSize) / RecordSize;
+    if (m_map) {
+        m_records = reinterpret_cast<const ReviewRecord *>(m_map + HeaderSize);
+    } else {
+        m_fallback.resize(int(m_count));
+        std::memcpy(m_fallback.data(), data + HeaderSize, size_t(m_count * RecordSize));
+        m_records = m_fallback.constData();
+    }
+    return true;
+}
+
+void ReviewLogReader::close()
+{
+    if (m_map) m_file.unmap(m_map);
+    m_file.close();
+    m_map = nullptr;
+    m_fallback.clear();
+    m_records = nullptr;
+    m_count = 0;
+}
+
+ReviewLogScan ReviewLogReader::scan() const
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    ReviewLogScan s;
+    for (const ReviewRecord &r : *this) {
+        if (r.kind != ReviewRecord::Review) continue;
+        if (s.reviews++ == 0) s.firstTimestamp = r.timestamp;
+        s.lastTimestamp = r.timestamp;
+        ++s.gradeCounts[qMin<int>(r.grade, 5)];
+        s.totalLatencyMs += r.latencyMs;
+    }
+    s.scanMs = timer.elapsed();
+    return s;
+}
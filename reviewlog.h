@@ -0,0 +1,112 @@
+#ifndef REVIEWLOG_H
+#define REVIEWLOG_H
+
+#include <QFile>
+#include <QMutex>
+#include <QString>
+#include <QVector>
+
+/*
+ * ReviewLog (append-only binary log of every answered card, reviews.log)
+ *
+ * Layout (native byte order, checked through an endian marker):
+ *   header  "FCRL", quint32 version, quint32 recordSize, quint32 endianMarker
+ *   records ReviewRecord, fixed 32 bytes each, in the order they were answered
+ *
+ *  - Card ids are only unique within a deck, so every record carries the key
+ *    of its deck's name. Renaming or removing a deck appends a marker record,
+ *    which lets a reader follow a review to the deck that holds it now.
+ *  - ReviewLogWriter buffers records in memory and appends them in one write
+ *    once the buffer fills, on flush() and on destruction. A torn record left
+ *    by a crash or a short write is cut off the next time the log is opened,
+ *    and only the records that didn't land are written again. While the file
+ *    can't be written, up to 64k records wait in memory; past that append()
+ *    drops the record and reports the error.
+ *  - ReviewLogReader mmaps the file and hands out the records in place, so a
+ *    scan is a walk over a flat array.
+ *  - Version 1 logs (24-byte records without a deck key) are read with a deck
+ *    key of 0, and rewritten as version 2 the first time they're appended to.
+ */
+
+struct ReviewRecord
+{
+    enum Kind : quint8 { Review = 0, RenameDeck = 1, RemoveDeck = 2 };
+
+    quint64 cardId = 0;       // RenameDeck: the key of the new name
+    quint64 deckKey = 0;      // keyOf() the deck's name at the time; 0 if unknown (version 1)
+    qint64 timestamp = 0;     // ms since the epoch
+    quint32 latencyMs = 0;    // from showing the card to checking the answer
+    quint8 grade = 0;         // SM-2 quality, 0-5
+    quint8 kind = Review;
+    quint8 reserved[2] = {};
+
+    // Stable across runs (unlike qHash) and never 0
+    static quint64 keyOf(const QString &deckName);
+};
+
+// Summary of a full pass over a log; also a throughput measurement
+struct ReviewLogScan
+{
+    qint64 reviews = 0;
+    qint64 gradeCounts[6] = {};
+    qint64 totalLatencyMs = 0;
+    qint64 firstTimestamp = 0;
+    qint64 lastTimestamp = 0;
+    qint64 scanMs = 0;
+};
+
+class ReviewLogWriter
+{
+public:
+    explicit ReviewLogWriter(const QString &path = QString(), int bufferRecords = 256);
+    ~ReviewLogWriter();
+    ReviewLogWriter(const ReviewLogWriter&) = delete;
+    ReviewLogWriter& operator=(const ReviewLogWriter&) = delete;
+
+    void setPath(const QString &path);   // flushes to the old path first
+    QString path() const;
+
+    bool append(const ReviewRecord &record, QString *errorOut = nullptr);
+    bool flush(QString *errorOut = nullptr);
+
+private:
+    bool ensureOpen(QString *errorOut);
+    bool upgrade(QString *errorOut);
+    bool flushLocked(QString *errorOut);
+
+    mutable QMutex m_mutex;
+    QString m_path;
+    QFile m_file;
+    QVector<ReviewRecord> m_buffer;
+    int m_bufferRecords;
+};
+
+class ReviewLogReader
+{
+public:
+    static const quint32 Version = 2;
+
+    ReviewLogReader() = default;
+    ~ReviewLogReader();
+    ReviewLogReader(const ReviewLogReader&) = delete;
+    ReviewLogReader& operator=(const ReviewLogReader&) = delete;
+
+    bool open(const QString &path, QString *errorOut = nullptr);   // a missing file reads as empty
+    void close();
+
+    qint64 count() const { return m_count; }
+    const ReviewRecord &at(qint64 index) const { return m_records[index]; }
+    const ReviewRecord *begin() const { return m_records; }
+    const ReviewRecord *end() const { return m_records + m_count; }
+
+    ReviewLogScan scan() const;
+
+private:
+    QFile m_file;
+    uchar *m_map = nullptr;
+    QVector<ReviewRecord> m_fallback;   // used when the platform can't map the file
+    const ReviewRecord *m_records = nullptr;
+    qint64 m_count = 0;
+};
+
+#endif // REVIEWLOG_H
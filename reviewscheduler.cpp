@@ -0,0 +1,360 @@
+#include "reviewscheduler.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QSaveFile>
+#include <QSet>
+#include <algorithm>
+#include <cmath>
+
+static const int Version = 1;
+static const qint64 SecondsPerDay = 24 * 60 * 60;
+static const qint64 RelearnSeconds = 10 * 60;
+static const qint32 MaxInterval = 36500;
+static const int MinEase = 1300;
+static const int MaxEase = 0xFFFF;
+
+// Min-heaps through std::*_heap, which build max-heaps: "later" sorts first
+template <typename Entry>
+static bool later(const Entry &a, const Entry &b)
+{
+    return a.due != b.due ? a.due > b.due : a.order > b.order;
+}
+
+CardSchedule ReviewScheduler::review(CardSchedule s, int quality, qint64 now)
+{
+    quality = qBound(0, quality, 5);
+    if (s.reviews < 0xFFFF) ++s.reviews;
+
+    if (quality < 3) {
+        // Start over without touching the ease, and see it again this session
+        if (s.repetitions > 0 && s.lapses < 0xFFFF) ++s.lapses;
+        s.repetitions = 0;
+        s.interval = 0;
+        s.due = now + RelearnSeconds;
+        return s;
+    }
+
+    if (s.repetitions < 0xFFFF) ++s.repetitions;
+    if (s.repetitions == 1) s.interval = 1;
+    else if (s.repetitions == 2) s.interval = 6;
+    else s.interval = qMin(MaxInterval, qMax(s.interval + 1, qint32(std::lround(s.interval * (s.ease / 1000.0)))));
+    s.due = now + s.interval * SecondsPerDay;
+
+    const int miss = 5 - quality;
+    s.ease = clampEase(s.ease + 100 - miss * (80 + miss * 20));
+    return s;
+}
+
+quint16 ReviewScheduler::clampEase(int ease)
+{
+    return quint16(qBound(MinEase, ease, MaxEase));
+}
+
+int ReviewScheduler::deckSlot(const QString &deckName, bool create)
+{
+    auto it = m_deckSlots.constFind(deckName);
+    if (it != m_deckSlots.constEnd()) return it.value();
+    if (!create) return -1;
+
+    int slot;
+    if (!m_freeSlots.isEmpty()) {
+        slot = m_freeSlots.takeLast();
+    } else {
+        slot = m_decks.size();
+        m_decks.append(DeckState());
+    }
+    m_decks[slot].name = deckName;
+    m_deckSlots.insert(deckName, slot);
+    return slot;
+}
+
+void ReviewScheduler::push(DeckState &d, quint64 id, qint64 due)
+{
+    d.heap.append(CardEntry{ due, ++m_order, id });
+    std::push_heap(d.heap.begin(), d.heap.end(), later<CardEntry>);
+
+    if (d.heap.size() > 2 * d.cards.size() + 64) {
+        // Mostly superseded entries: keep the live ones (and their order) and re-heapify
+        auto stale = [&d](const CardEntry &e) {
+            auto it = d.cards.constFind(e.id);
+            return it == d.cards.constEnd() || it->due != e.due;
+        };
+        d.heap.erase(std::remove_if(d.heap.begin(), d.heap.end(), stale), d.heap.end());
+        std::make_heap(d.heap.begin(), d.heap.end(), later<CardEntry>);
+    }
+}
+
+// Drops superseded entries off the top of the deck's heap
+bool ReviewScheduler::top(DeckState &d, CardEntry *out)
+{
+    while (!d.heap.isEmpty()) {
+        const CardEntry &e = d.heap.front();
+        auto it = d.cards.constFind(e.id);
+        if (it != d.cards.constEnd() && it->due == e.due) {
+            *out = e;
+            return true;
+        }
+        std::pop_heap(d.heap.begin(), d.heap.end(), later<CardEntry>);
+        d.heap.removeLast();
+    }
+    return false;
+}
+
+// Puts the deck's current top into the library heap; call after every change to the deck
+void ReviewScheduler::publish(int slot)
+{
+    DeckState &d = m_decks[slot];
+    CardEntry e;
+    if (!top(d, &e)) {
+        d.published = false;
+        return;
+    }
+    if (d.published && d.publishedDue == e.due && d.publishedOrder == e.order) return;
+
+    d.published = true;
+    d.publishedDue = e.due;
+    d.publishedOrder = e.order;
+    m_deckHeap.append(DeckEntry{ e.due, e.order, slot });
+    std::push_heap(m_deckHeap.begin(), m_deckHeap.end(), later<DeckEntry>);
+
+    if (m_deckHeap.size() > 2 * m_deckSlots.size() + 64) {
+        auto stale = [this](const DeckEntry &x) {
+            const DeckState &s = m_decks[x.deck];
+            return !s.published || s.publishedDue != x.due || s.publishedOrder != x.order;
+        };
+        m_deckHeap.erase(std::remove_if(m_deckHeap.begin(), m_deckHeap.end(), stale), m_deckHeap.end());
+        std::make_heap(m_deckHeap.begin(), m_deckHeap.end(), later<DeckEntry>);
+    }
+}
+
+CardSchedule ReviewScheduler::schedule(const QString &deckName, quint64 id) const
+{
+    const int slot = m_deckSlots.value(deckName, -1);
+    return slot >= 0 ? m_decks[slot].cards.value(id) : CardSchedule();
+}
+
+void ReviewScheduler::set(const QString &deckName, quint64 id, const CardSchedule &s)
+{
+    if (id == 0) return;
+    const int slot = deckSlot(deckName, true);
+    DeckState &d = m_decks[slot];
+    auto it = d.cards.find(id);
+    if (it == d.cards.end()) {
+        d.cards.insert(id, s);
+        ++m_cards;
+    } else {
+        *it = s;
+    }
+    push(d, id, s.due);
+    publish(slot);
+}
+
+void ReviewScheduler::addNew(const QString &deckName, quint64 id, qint64 now)
+{
+    if (id == 0) return;
+    const int slot = deckSlot(deckName, true);
+    if (m_decks[slot].cards.contains(id)) return;
+
+    CardSchedule s;
+    s.due = now;
+    set(deckName, id, s);
+}
+
+void ReviewScheduler::syncDeck(const QString &deckName, const QVector<quint64> &ids, qint64 now)
+{
+    const int slot = deckSlot(deckName, true);
+    DeckState &d = m_decks[slot];
+
+    const QSet<quint64> present(ids.constBegin(), ids.constEnd());
+    for (auto it = d.cards.begin(); it != d.cards.end();) {
+        if (present.contains(it.key())) {
+            ++it;
+        } else {
+            it = d.cards.erase(it);
+            --m_cards;
+        }
+    }
+    for (quint64 id : ids) {
+        if (id == 0 || d.cards.contains(id)) continue;
+        CardSchedule s;
+        s.due = now;
+        d.cards.insert(id, s);
+        ++m_cards;
+        push(d, id, now);
+    }
+    publish(slot);
+}
+
+void ReviewScheduler::removeCard(const QString &deckName, quint64 id)
+{
+    const int slot = m_deckSlots.value(deckName, -1);
+    if (slot < 0 || !m_decks[slot].cards.remove(id)) return;
+    --m_cards;
+    publish(slot);
+}
+
+void ReviewScheduler::removeDeck(const QString &deckName)
+{
+    auto found = m_deckSlots.find(deckName);
+    if (found == m_deckSlots.end()) return;
+    const int slot = found.value();
+    m_deckSlots.erase(found);
+
+    m_cards -= m_decks[slot].cards.size();
+    m_decks[slot] = DeckState();   // unpublished, so its library heap entries go stale
+    m_freeSlots.append(slot);
+}
+
+void ReviewScheduler::renameDeck(const QString &from, const QString &to)
+{
+    if (from == to || !m_deckSlots.contains(from)) return;
+    removeDeck(to);
+
+    const int slot = m_deckSlots.take(from);
+    m_deckSlots.insert(to, slot);
+    m_decks[slot].name = to;
+}
+
+void ReviewScheduler::clear()
+{
+    *this = ReviewScheduler();
+}
+
+DueCard ReviewScheduler::nextInDeck(int slot)
+{
+    DeckState &d = m_decks[slot];
+    CardEntry e;
+    if (!top(d, &e)) return DueCard();
+
+    DueCard c;
+    c.deckName = d.name;
+    c.cardId = e.id;
+    c.due = e.due;
+    c.isNew = d.cards.value(e.id).isNew();
+    return c;
+}
+
+DueCard ReviewScheduler::next(const QString &deckName)
+{
+    if (!deckName.isEmpty()) {
+        const int slot = m_deckSlots.value(deckName, -1);
+        return slot >= 0 ? nextInDeck(slot) : DueCard();
+    }
+
+    while (!m_deckHeap.isEmpty()) {
+        const DeckEntry &e = m_deckHeap.front();
+        const DeckState &d = m_decks[e.deck];
+        if (d.published && d.publishedDue == e.due && d.publishedOrder == e.order) return nextInDeck(e.deck);
+        std::pop_heap(m_deckHeap.begin(), m_deckHeap.end(), later<DeckEntry>);
+        m_deckHeap.removeLast();
+    }
+    return DueCard();
+}
+
+int ReviewScheduler::cardCount(const QString &deckName) const
+{
+    const int slot = m_deckSlots.value(deckName, -1);
+    return slot >= 0 ? m_decks[slot].cards.size() : 0;
+}
+
+int ReviewScheduler::cardCount() const
+{
+    return m_cards;
+}
+
+QJsonObject ReviewScheduler::toJson() const
+{
+    QJsonArray decks;
+    for (const DeckState &d : m_decks) {
+        if (d.name.isEmpty()) continue;
+
+        QJsonArray cards;
+        for (auto it = d.cards.constBegin(); it != d.cards.constEnd(); ++it) {
+            const CardSchedule &s = it.value();
+            if (s.isNew()) continue;   // recreated from the deck on the next sync
+            cards.append(QJsonArray{ QString::number(it.key()), double(s.due), s.interval,
+                                     s.ease, s.repetitions, s.lapses, s.reviews });
+        }
+        if (cards.isEmpty()) continue;
+
+        QJsonObject o;
+        o["name"] = d.name;
+        o["cards"] = cards;
+        decks.append(o);
+    }
+
+    QJsonObject root;
+    root["version"] = Version;
+    root["decks"] = decks;
+    return root;
+}
+
+ReviewScheduler ReviewScheduler::fromJson(const QJsonObject &o)
+{
+    ReviewScheduler out;
+    const QJsonArray decks = o.value("decks").toArray();
+    for (const QJsonValue &v : decks) {
+        const QJsonObject deckObj = v.toObject();
+        const int slot = out.deckSlot(deckObj.value("name").toString(), true);
+        DeckState &d = out.m_decks[slot];
+
+        // Fill the heap unordered, then heapify once
+        const QJsonArray cards = deckObj.value("cards").toArray();
+        d.cards.reserve(cards.size());
+        for (const QJsonValue &c : cards) {
+            const QJsonArray a = c.toArray();
+            const quint64 id = a.at(0).toString().toULongLong();
+            if (id == 0 || d.cards.contains(id)) continue;
+
+            CardSchedule s;
+            s.due = qint64(a.at(1).toDouble());
+            s.interval = qBound(0, a.at(2).toInt(), MaxInterval);
+            s.ease = clampEase(a.at(3).toInt(2500));
+            s.repetitions = quint16(a.at(4).toInt());
+            s.lapses = quint16(a.at(5).toInt());
+            s.reviews = quint16(a.at(6).toInt());
+            d.cards.insert(id, s);
+            d.heap.append(CardEntry{ s.due, ++out.m_order, id });
+        }
+        out.m_cards += d.cards.size();
+        std::make_heap(d.heap.begin(), d.heap.end(), later<CardEntry>);
+        out.publish(slot);
+    }
+    return out;
+}
+
+bool ReviewScheduler::write(const QString &path, QString *errorOut) const
+{
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QSaveFile f(path);
+    if (!f.open(QIODevice::WriteOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for writing.").arg(path);
+        return false;
+    }
+    const QByteArray data = QJsonDocument(toJson()).toJson(QJsonDocument::Compact);
+    if (f.write(data) != data.size() || !f.commit()) {
+        if (errorOut) *errorOut = QString("Could not write %1.").arg(path);
+        return false;
+    }
+    return true;
+}
+
+bool ReviewScheduler::read(const QString &path, ReviewScheduler &out, QString *errorOut)
+{
+    QFile f(path);
+    if (!f.open(QIODevice::ReadOnly)) {
+        if (errorOut) *errorOut = QString("Could not open %1 for reading.").arg(path);
+        return false;
+    }
+    const QJsonDocument doc = QJsonDocument::fromJson(f.readAll());
+    if (!doc.isObject() || doc.object().value("version").toInt() != Version) {
+        if (errorOut) *errorOut = QString("Invalid review schedule in %1.").arg(path);
+        return false;
+    }
+    out = fromJson(doc.object());
+    return true;
+}
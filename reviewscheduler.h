@@ -0,0 +1,113 @@
+#ifndef REVIEWSCHEDULER_H
+#define REVIEWSCHEDULER_H
+
+#include <QHash>
+#include <QJsonObject>
+#include <QString>
+#include <QVector>
+
+/*
+ * ReviewScheduler (spaced repetition, SM-2)
+ *
+ *  - Every card has a due time, an interval in days, an ease factor and its
+ *    review counts. review() grades a card on the SM-2 scale (0-5): a failed
+ *    card starts over and comes back within minutes, a passed one is pushed
+ *    out by 1 day, then 6, then interval x ease.
+ *  - Each deck keeps a min-heap of its cards by due time and the library keeps
+ *    a heap of decks by their earliest card, so the next card of a deck or of
+ *    the whole library is found in O(log n). Rescheduling pushes a new entry
+ *    and leaves the old one to be skipped when it surfaces; heaps are rebuilt
+ *    once they hold twice as many entries as cards.
+ *  - Cards that were never reviewed are "new", due from when they were added;
+ *    only reviewed cards are written by toJson().
+ *  - Times are seconds since the epoch.
+ *  - Not thread-safe; flashcardManager only uses it under its own mutex.
+ */
+
+struct CardSchedule
+{
+    qint64 due = 0;
+    qint32 interval = 0;       // days; 0 while new or relearning
+    quint16 ease = 2500;       // SM-2 ease factor x 1000, at least 1300
+    quint16 repetitions = 0;   // passed reviews in a row
+    quint16 lapses = 0;        // passed cards that were later failed
+    quint16 reviews = 0;
+
+    bool isNew() const { return reviews == 0; }
+};
+
+struct DueCard
+{
+    QString deckName;
+    quint64 cardId = 0;        // 0 = nothing scheduled
+    qint64 due = 0;
+    bool isNew = false;
+};
+
+class ReviewScheduler
+{
+public:
+    enum Grade { Again = 1, Hard = 3, Good = 4, Easy = 5 };
+
+    static CardSchedule review(CardSchedule s, int quality, qint64 now);
+    static quint16 clampEase(int ease);   // into [1300, 65535]; use on anything read from disk
+
+    CardSchedule schedule(const QString &deckName, quint64 id) const;   // a new card's if unknown
+    void set(const QString &deckName, quint64 id, const CardSchedule &s);
+    void addNew(const QString &deckName, quint64 id, qint64 now);     // no-op if already scheduled
+    // Makes the deck's schedule cover exactly ids; new ones are due at now, in order
+    void syncDeck(const QString &deckName, const QVector<quint64> &ids, qint64 now);
+    void removeCard(const QString &deckName, quint64 id);
+    void removeDeck(const QString &deckName);
+    void renameDeck(const QString &from, const QString &to);
+    void clear();
+
+    // Earliest card of the deck, or of the library when deckName is empty; it may not be due yet.
+    // Not const: stale heap entries are dropped on the way.
+    DueCard next(const QString &deckName = QString());
+    int cardCount(const QString &deckName) const;
+    int cardCount() const;
+
+    QJsonObject toJson() const;
+    static ReviewScheduler fromJson(const QJsonObject &o);
+    bool write(const QString &path, QString *errorOut = nullptr) const;
+    static bool read(const QString &path, ReviewScheduler &out, QString *errorOut = nullptr);
+
+private:
+    struct CardEntry
+    {
+        qint64 due;
+        quint64 order;   // ties go first come, first served
+        quint64 id;
+    };
+    struct DeckEntry
+    {
+        qint64 due;
+        quint64 order;
+        int deck;
+    };
+    struct DeckState
+    {
+        QString name;                           // empty once the deck is removed
+        QHash<quint64, CardSchedule> cards;
+        QVector<CardEntry> heap;
+        bool published = false;                 // heap top is in m_deckHeap
+        qint64 publishedDue = 0;
+        quint64 publishedOrder = 0;
+    };
+
+    int deckSlot(const QString &deckName, bool create);
+    void push(DeckState &d, quint64 id, qint64 due);
+    bool top(DeckState &d, CardEntry *out);
+    void publish(int slot);
+    DueCard nextInDeck(int slot);
+
+    QVector<DeckState> m_decks;
+    QHash<QString, int> m_deckSlots;
+    QVector<int> m_freeSlots;
+    QVector<DeckEntry> m_deckHeap;
+    quint64 m_order = 0;
+    int m_cards = 0;
+};
+
+#endif // REVIEWSCHEDULER_H
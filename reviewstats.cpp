@@ -0,0 +1,110 @@
+#include "reviewstats.h"
+
+#include <QtAlgorithms>
+#include <cmath>
+
+static const int SubBuckets = 8;
+static const int ExactBelow = 16;
+
+int LatencyHistogram::bucketOf(quint32 ms)
+{
+    if (ms < quint32(ExactBelow)) return int(ms);
+    const int exponent = 31 - int(qCountLeadingZeroBits(ms));           // >= 4
+    const int sub = int(ms >> (exponent - 3)) & (SubBuckets - 1);       // 3 bits below the leading one
+    return ExactBelow + (exponent - 4) * SubBuckets + sub;
+}
+
+quint32 LatencyHistogram::bucketLow(int bucket)
+{
+    if (bucket < ExactBelow) return quint32(bucket);
+    const int exponent = (bucket - ExactBelow) / SubBuckets + 4;
+    const int sub = (bucket - ExactBelow) % SubBuckets;
+    return quint32(SubBuckets + sub) << (exponent - 3);
+}
+
+quint32 LatencyHistogram::bucketHigh(int bucket)
+{
+    return bucket + 1 < Buckets ? bucketLow(bucket + 1) - 1 : 0xFFFFFFFFu;
+}
+
+void LatencyHistogram::add(quint32 ms)
+{
+    ++m_counts[bucketOf(ms)];
+    ++m_count;
+}
+
+quint32 LatencyHistogram::percentile(double p) const
+{
+    if (m_count == 0) return 0;
+    const qint64 rank = qMax<qint64>(1, qint64(std::ceil(qBound(0.0, p, 100.0) / 100.0 * m_count)));
+    qint64 seen = 0;
+    for (int b = 0; b < Buckets; ++b) {
+        seen += m_counts[b];
+        if (seen >= rank) return bucketHigh(b);
+    }
+    return bucketHigh(Buckets - 1);
+}
+
+void ReviewAggregate::add(const ReviewRecord &r)
+{
+    ++reviews;
+    if (ReviewStats::isCorrect(r)) {
+        ++correct;
+        bestStreak = qMax(bestStreak, ++streak);
+    } else {
+        streak = 0;
+    }
+    totalLatencyMs += r.latencyMs;
+    lastReview = qMax(lastReview, r.timestamp);
+    latency.add(r.latencyMs);
+}
+
+void ReviewStats::add(const QString &deckName, const QStringList &tagKeys, const ReviewRecord &r)
+{
+    m_library.add(r);
+    m_decks[deckName].add(r);
+    for (const QString &key : tagKeys) m_tags[key].add(r);
+
+    CardReviewStats &c = m_cards[deckName][r.cardId];
+    ++c.reviews;
+    if (isCorrect(r)) {
+        ++c.correct;
+        if (c.streak < 0xFFFF) ++c.streak;
+        c.bestStreak = qMax(c.bestStreak, c.streak);
+    } else {
+        c.streak = 0;
+    }
+    c.totalLatencyMs = quint32(qMin<quint64>(quint64(c.totalLatencyMs) + r.latencyMs, 0xFFFFFFFFu));
+    c.lastReview = qMax(c.lastReview, r.timestamp);
+}
+
+void ReviewStats::removeCard(const QString &deckName, quint64 id)
+{
+    auto it = m_cards.find(deckName);
+    if (it != m_cards.end()) it.value().remove(id);
+}
+
+void ReviewStats::removeDeck(const QString &deckName)
+{
+    m_decks.remove(deckName);
+    m_cards.remove(deckName);
+}
+
+void ReviewStats::renameDeck(const QString &from, const QString &to)
+{
+    if (from == to) return;
+    removeDeck(to);
+    if (m_decks.contains(from)) m_decks.insert(to, m_decks.take(from));
+    if (m_cards.contains(from)) m_cards.insert(to, m_cards.take(from));
+}
+
+void ReviewStats::clear()
+{
+    *this = ReviewStats();
+}
+
+CardReviewStats ReviewStats::card(const QString &deckName, quint64 id) const
+{
+    auto it = m_cards.constFind(deckName);
+    return it != m_cards.constEnd() ? it.value().value(id) : CardReviewStats();
+}
@@ -0,0 +1,96 @@
+#ifndef REVIEWSTATS_H
+#define REVIEWSTATS_H
+
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include "reviewlog.h"
+
+/*
+ * ReviewStats (running review aggregates per card, deck, tag and library)
+ *
+ *  - add() folds one review into the aggregates of its card, its deck, each of
+ *    the deck's tags and the library, in time independent of how many reviews
+ *    came before. Nothing is ever rescanned to answer a query.
+ *  - A review counts as correct at SM-2 grade 3 or better. Streaks count
+ *    correct answers in a row; a wrong answer resets the current one.
+ *  - Deck, tag and library aggregates carry a latency histogram. Cards only
+ *    keep their total latency, to stay small.
+ *  - Tags are credited with the deck's tags at review time; retagging a deck
+ *    doesn't move its history.
+ *  - Not thread-safe; flashcardManager only uses it under its own mutex.
+ */
+
+// Log-linear buckets in the style of HdrHistogram: exact below 16 ms, then 8
+// buckets per power of two, so any value is off by at most 1/8 of itself.
+class LatencyHistogram
+{
+public:
+    static const int Buckets = 16 + 28 * 8;
+
+    void add(quint32 ms);
+    qint64 count() const { return m_count; }
+    quint32 percentile(double p) const;   // p in [0, 100]; upper bound of the bucket it lands in
+    quint32 bucketCount(int bucket) const { return m_counts[bucket]; }
+    static int bucketOf(quint32 ms);
+    static quint32 bucketLow(int bucket);
+    static quint32 bucketHigh(int bucket);
+
+private:
+    quint32 m_counts[Buckets] = {};
+    qint64 m_count = 0;
+};
+
+struct CardReviewStats
+{
+    quint32 reviews = 0;
+    quint32 correct = 0;
+    quint16 streak = 0;
+    quint16 bestStreak = 0;
+    quint32 totalLatencyMs = 0;   // saturates
+    qint64 lastReview = 0;        // ms since the epoch
+
+    double accuracy() const { return reviews ? double(correct) / reviews : 0.0; }
+};
+
+struct ReviewAggregate
+{
+    qint64 reviews = 0;
+    qint64 correct = 0;
+    int streak = 0;
+    int bestStreak = 0;
+    qint64 totalLatencyMs = 0;
+    qint64 lastReview = 0;
+    LatencyHistogram latency;
+
+    void add(const ReviewRecord &r);
+    double accuracy() const { return reviews ? double(correct) / reviews : 0.0; }
+    double meanLatencyMs() const { return reviews ? double(totalLatencyMs) / reviews : 0.0; }
+};
+
+class ReviewStats
+{
+public:
+    static bool isCorrect(const ReviewRecord &r) { return r.grade >= 3; }
+
+    void add(const QString &deckName, const QStringList &tagKeys, const ReviewRecord &r);
+    void removeCard(const QString &deckName, quint64 id);   // the deck keeps the card's history
+    void removeDeck(const QString &deckName);
+    void renameDeck(const QString &from, const QString &to);
+    void clear();
+
+    const ReviewAggregate &library() const { return m_library; }
+    ReviewAggregate deck(const QString &deckName) const { return m_decks.value(deckName); }
+    ReviewAggregate tag(const QString &tagKey) const { return m_tags.value(tagKey); }
+    CardReviewStats card(const QString &deckName, quint64 id) const;
+    QStringList deckNames() const { return m_decks.keys(); }
+    QStringList tagKeys() const { return m_tags.keys(); }
+
+private:
+    ReviewAggregate m_library;
+    QHash<QString, ReviewAggregate> m_decks;
+    QHash<QString, ReviewAggregate> m_tags;
+    QHash<QString, QHash<quint64, CardReviewStats>> m_cards;
+};
+
+#endif // REVIEWSTATS_H
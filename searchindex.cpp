@@ -0,0 +1,292 @@
+#include "searchindex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+static const int MaxTermLength = 64;
+static const int MinDeadDocsToCompact = 4096;
+
+// Case-folded words of text, each once
+static QVector<QString> words(QStringView text)
+{
+    QVector<QString> out;
+    const int n = int(text.size());
+    int i = 0;
+    while (i < n) {
+        while (i < n && !text.at(i).isLetterOrNumber()) ++i;
+        const int start = i;
+        while (i < n && text.at(i).isLetterOrNumber()) ++i;
+        if (i == start) continue;
+
+        const QString w = text.mid(start, qMin(i - start, MaxTermLength)).toString().toCaseFolded();
+        if (!out.contains(w)) out.append(w);
+    }
+    return out;
+}
+
+static quint64 trigram(const QChar *p)
+{
+    return (quint64(p[0].unicode()) << 32) | (quint64(p[1].unicode()) << 16) | quint64(p[2].unicode());
+}
+
+int SearchIndex::termId(const QString &term)
+{
+    auto it = m_termIds.constFind(term);
+    if (it != m_termIds.constEnd()) return it.value();
+
+    const int id = m_terms.size();
+    m_terms.append(term);
+    m_termIds.insert(term, id);
+    m_postings.append(QVector<quint32>());
+    for (int i = 0; i + 3 <= term.size(); ++i) {
+        QVector<int> &list = m_trigrams[trigram(term.constData() + i)];
+        if (list.isEmpty() || list.last() != id) list.append(id);
+    }
+
+    // Merging costs a pass over the sorted list, so let the backlog grow with it
+    m_pendingTerms.append(id);
+    if (m_pendingTerms.size() >= qMax(1024, m_sortedTerms.size() / 8)) mergePendingTerms();
+    return id;
+}
+
+void SearchIndex::mergePendingTerms()
+{
+    auto less = [this](int a, int b) { return m_terms[a] < m_terms[b]; };
+    std::sort(m_pendingTerms.begin(), m_pendingTerms.end(), less);
+
+    QVector<int> merged(m_sortedTerms.size() + m_pendingTerms.size());
+    std::merge(m_sortedTerms.constBegin(), m_sortedTerms.constEnd(),
+               m_pendingTerms.constBegin(), m_pendingTerms.constEnd(), merged.begin(), less);
+    m_sortedTerms = merged;
+    m_pendingTerms.clear();
+}
+
+void SearchIndex::addCard(const QString &deckName, quint64 id, QStringView question, QStringView answer)
+{
+    if (id == 0) return;
+
+    int slot = m_deckSlots.value(deckName, -1);
+    if (slot < 0) {
+        slot = m_deckNames.size();
+        m_deckNames.append(deckName);
+        m_deckSlots.insert(deckName, slot);
+        m_deckDocs.append(QHash<quint64, quint32>());
+    }
+
+    QHash<quint64, quint32> &docs = m_deckDocs[slot];
+    auto existing = docs.constFind(id);
+    if (existing != docs.constEnd()) retire(existing.value());
+
+    const quint32 doc = quint32(m_docs.size());
+    Doc d;
+    d.deck = slot;
+    d.card = id;
+    m_docs.append(d);
+    docs.insert(id, doc);
+
+    const QVector<QString> inQuestion = words(question);
+    for (const QString &w : inQuestion) m_postings[termId(w)].append(doc << 1 | 1);
+    for (const QString &w : words(answer)) {
+        if (!inQuestion.contains(w)) m_postings[termId(w)].append(doc << 1);
+    }
+}
+
+void SearchIndex::updateCard(const QString &deckName, quint64 id, QStringView question, QStringView answer)
+{
+    addCard(deckName, id, question, answer);   // retires the old entry
+    compact();
+}
+
+void SearchIndex::removeCard(const QString &deckName, quint64 id)
+{
+    const int slot = m_deckSlots.value(deckName, -1);
+    if (slot < 0) return;
+
+    auto it = m_deckDocs[slot].find(id);
+    if (it == m_deckDocs[slot].end()) return;
+    retire(it.value());
+    m_deckDocs[slot].erase(it);
+    compact();
+}
+
+void SearchIndex::removeDeck(const QString &deckName)
+{
+    auto found = m_deckSlots.find(deckName);
+    if (found == m_deckSlots.end()) return;
+    const int slot = found.value();
+    m_deckSlots.erase(found);
+
+    for (quint32 doc : std::as_const(m_deckDocs[slot])) retire(doc);
+    m_deckDocs[slot].clear();
+    m_deckNames[slot].clear();
+    compact();
+}
+
+void SearchIndex::renameDeck(const QString &from, const QString &to)
+{
+    if (from == to || !m_deckSlots.contains(from)) return;
+    removeDeck(to);
+
+    const int slot = m_deckSlots.take(from);
+    m_deckSlots.insert(to, slot);
+    m_deckNames[slot] = to;
+}
+
+void SearchIndex::clear()
+{
+    *this = SearchIndex();
+}
+
+void SearchIndex::retire(quint32 doc)
+{
+    m_docs[int(doc)].card = 0;
+    ++m_deadDocs;
+}
+
+// Renumbers the live cards once enough are retired and drops the rest from the postings
+void SearchIndex::compact()
+{
+    if (m_deadDocs < MinDeadDocsToCompact || m_deadDocs * 4 < m_docs.size()) return;
+
+    QVector<quint32> remap(m_docs.size());
+    QVector<Doc> live;
+    live.reserve(m_docs.size() - m_deadDocs);
+    for (int i = 0; i < m_docs.size(); ++i) {
+        if (m_docs[i].card == 0) continue;
+        remap[i] = quint32(live.size());
+        live.append(m_docs[i]);
+    }
+
+    for (QVector<quint32> &list : m_postings) {
+        int out = 0;
+        for (int i = 0; i < list.size(); ++i) {
+            const quint32 doc = list[i] >> 1;
+            if (m_docs[int(doc)].card == 0) continue;
+            list[out++] = remap[int(doc)] << 1 | (list[i] & 1);
+        }
+        list.resize(out);
+        list.squeeze();
+    }
+    for (QHash<quint64, quint32> &docs : m_deckDocs) {
+        for (auto it = docs.begin(); it != docs.end(); ++it) it.value() = remap[int(it.value())];
+    }
+
+    m_docs = live;
+    m_deadDocs = 0;
+}
+
+// Terms the word matches, with how well: 1 for the word itself, less the more of
+// the term it leaves uncovered, and less again inside a term than at its start.
+QVector<QPair<int, float>> SearchIndex::matchTerms(const QString &word, Match mode) const
+{
+    QVector<QPair<int, float>> out;
+    auto consider = [&](int t) {
+        const QString &term = m_terms[t];
+        if (term.size() == word.size()) {
+            if (term == word) out.append(qMakePair(t, 1.0f));
+            return;
+        }
+        const float coverage = float(word.size()) / float(term.size());
+        if (term.startsWith(word)) out.append(qMakePair(t, 0.6f * coverage));
+        else if (mode == Match::Substring && term.contains(word)) out.append(qMakePair(t, 0.3f * coverage));
+    };
+
+    if (mode == Match::Prefix) {
+        auto it = std::lower_bound(m_sortedTerms.constBegin(), m_sortedTerms.constEnd(), word,
+                                   [this](int t, const QString &w) { return m_terms[t] < w; });
+        for (; it != m_sortedTerms.constEnd() && m_terms[*it].startsWith(word); ++it) consider(*it);
+        for (int t : m_pendingTerms) consider(t);
+        return out;
+    }
+
+    if (word.size() < 3) {
+        // Too short for a trigram; the term list is still far smaller than the cards
+        for (int t = 0; t < m_terms.size(); ++t) consider(t);
+        return out;
+    }
+
+    // Every term containing the word contains each of its trigrams; check the rarest
+    const QVector<int> *candidates = nullptr;
+    for (int i = 0; i + 3 <= word.size(); ++i) {
+        auto it = m_trigrams.constFind(trigram(word.constData() + i));
+        if (it == m_trigrams.constEnd()) return out;
+        if (!candidates || it.value().size() < candidates->size()) candidates = &it.value();
+    }
+    for (int t : *candidates) consider(t);
+    return out;
+}
+
+QVector<SearchHit> SearchIndex::search(const QString &query, Match mode, int limit) const
+{
+    const QVector<QString> queryWords = words(query);
+    if (queryWords.isEmpty() || limit <= 0) return QVector<SearchHit>();
+
+    struct Word
+    {
+        QVector<QPair<int, float>> terms;
+        qint64 postings = 0;
+    };
+    QVector<Word> matched;
+    for (const QString &w : queryWords) {
+        Word m;
+        m.terms = matchTerms(w, mode);
+        if (m.terms.isEmpty()) return QVector<SearchHit>();
+        for (const auto &t : std::as_const(m.terms)) m.postings += m_postings[t.first].size();
+        matched.append(m);
+    }
+    // Rarest word first, so later words only probe its candidates
+    std::sort(matched.begin(), matched.end(), [](const Word &a, const Word &b) { return a.postings < b.postings; });
+
+    // Dense per-card arrays: a million cards is a few MB, far cheaper than hashing every posting
+    const double live = qMax(1, cardCount());
+    QVector<float> total(m_docs.size());
+    QVector<float> best(m_docs.size());        // current word's best term score
+    QVector<quint16> wordsMatched(m_docs.size());
+    QVector<quint32> touched;
+    for (int i = 0; i < matched.size(); ++i) {
+        touched.clear();
+        for (const auto &t : std::as_const(matched[i].terms)) {
+            const QVector<quint32> &list = m_postings[t.first];
+            if (list.isEmpty()) continue;
+            const float weight = float(std::log(1.0 + live / list.size())) * t.second;
+            for (quint32 e : list) {
+                const int doc = int(e >> 1);
+                if (m_docs[doc].card == 0 || wordsMatched[doc] < i) continue;   // missed an earlier word
+                if (wordsMatched[doc] == i) {
+                    wordsMatched[doc] = quint16(i + 1);
+                    touched.append(quint32(doc));
+                }
+                const float s = (e & 1) ? 2.0f * weight : weight;
+                if (s > best[doc]) best[doc] = s;
+            }
+        }
+        if (touched.isEmpty()) return QVector<SearchHit>();
+        for (quint32 doc : std::as_const(touched)) {
+            total[int(doc)] += best[int(doc)];
+            best[int(doc)] = 0.0f;
+        }
+    }
+
+    // touched now holds the cards that matched every word
+    QVector<QPair<float, quint32>> ranked;
+    ranked.reserve(touched.size());
+    for (quint32 doc : std::as_const(touched)) ranked.append(qMakePair(total[int(doc)], doc));
+    const int k = qMin(limit, ranked.size());
+    std::partial_sort(ranked.begin(), ranked.begin() + k, ranked.end(),
+                      [](const QPair<float, quint32> &a, const QPair<float, quint32> &b) {
+                          return a.first != b.first ? a.first > b.first : a.second < b.second;
+                      });
+
+    QVector<SearchHit> hits;
+    hits.reserve(k);
+    for (int i = 0; i < k; ++i) {
+        const Doc &d = m_docs[int(ranked[i].second)];
+        SearchHit h;
+        h.deckName = m_deckNames[d.deck];
+        h.cardId = d.card;
+        h.score = ranked[i].first;
+        hits.append(h);
+    }
+    return hits;
+}
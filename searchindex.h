@@ -0,0 +1,78 @@
+#ifndef SEARCHINDEX_H
+#define SEARCHINDEX_H
+
+#include <QHash>
+#include <QString>
+#include <QStringView>
+#include <QVector>
+
+/*
+ * SearchIndex (full-text index over card questions and answers)
+ *
+ *  - Text is split into case-folded words (runs of letters/digits). Each word is
+ *    a term with a posting list of the cards containing it, flagged when the word
+ *    occurs in the question.
+ *  - Prefix queries binary-search a sorted term list; substring queries go
+ *    through a trigram index over the terms, so neither walks every card.
+ *  - A query with several words matches cards that contain all of them. Hits are
+ *    ranked by the sum over query words of idf x (2 in the question, 1 in the
+ *    answer) x how much of the term the word covers.
+ *  - Cards are numbered internally; removing or editing a card retires its
+ *    number and the posting lists are compacted once a quarter of them are
+ *    retired. Terms are never dropped.
+ *  - Not thread-safe; flashcardManager only uses it under its own mutex.
+ */
+
+struct SearchHit
+{
+    QString deckName;
+    quint64 cardId = 0;
+    double score = 0.0;
+};
+
+class SearchIndex
+{
+public:
+    enum class Match { Prefix, Substring };
+
+    void addCard(const QString &deckName, quint64 id, QStringView question, QStringView answer);
+    void updateCard(const QString &deckName, quint64 id, QStringView question, QStringView answer);
+    void removeCard(const QString &deckName, quint64 id);
+    void removeDeck(const QString &deckName);
+    void renameDeck(const QString &from, const QString &to);
+    void clear();
+
+    QVector<SearchHit> search(const QString &query, Match mode = Match::Prefix, int limit = 100) const;
+
+    int cardCount() const { return m_docs.size() - m_deadDocs; }
+    int termCount() const { return m_terms.size(); }
+
+private:
+    struct Doc
+    {
+        int deck = -1;
+        quint64 card = 0;   // 0 = retired
+    };
+
+    int termId(const QString &term);
+    void retire(quint32 doc);
+    void mergePendingTerms();
+    void compact();
+    QVector<QPair<int, float>> matchTerms(const QString &word, Match mode) const;
+
+    QVector<Doc> m_docs;
+    int m_deadDocs = 0;
+
+    QVector<QString> m_deckNames;
+    QHash<QString, int> m_deckSlots;
+    QVector<QHash<quint64, quint32>> m_deckDocs;   // per deck slot: card id -> doc
+
+    QVector<QString> m_terms;
+    QHash<QString, int> m_termIds;
+    QVector<QVector<quint32>> m_postings;          // per term: doc << 1 | inQuestion, ascending
+    QVector<int> m_sortedTerms;                    // term ids in string order
+    QVector<int> m_pendingTerms;                   // new terms not merged into m_sortedTerms yet
+    QHash<quint64, QVector<int>> m_trigrams;       // three UTF-16 units -> term ids, ascending
+};
+
+#endif // SEARCHINDEX_H
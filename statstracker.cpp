@@ -1,55 +1,89 @@
 #include "statstracker.h"
 
-StatsTracker::StatsTracker(): settings("MyFlashcardApp", "Statistics") {}
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QTimer>
+
+static const int FlushIntervalMs = 5000;
+static const char *const Keys[] = { "decksCreated", "cardsCreated", "cardsReviewed", "answersCorrect", "answersIncorrect" };
+
+StatsTracker::StatsTracker(): settings("MyFlashcardApp", "Statistics") {
+    for (int c = 0; c < CounterCount; ++c) m_counts[c] = settings.value(Keys[c], 0).toInt();
+
+    // The timer belongs to the application thread (and object), whichever thread got here first
+    if (QCoreApplication *app = QCoreApplication::instance()) {
+        QMetaObject::invokeMethod(app, [this, app]() {
+            QTimer *timer = new QTimer(app);
+            QObject::connect(timer, &QTimer::timeout, app, [this]() { flush(); });
+            QObject::connect(app, &QCoreApplication::aboutToQuit, app, [this]() { flush(); });
+            timer->start(FlushIntervalMs);
+        });
+    }
+}
+
+StatsTracker::~StatsTracker() {
+    flush();
+}
 
 StatsTracker& StatsTracker::instance(){
     static StatsTracker instance;
     return instance;
 }
 
+void StatsTracker::track(Counter c) {
+    m_counts[c].fetch_add(1, std::memory_order_relaxed);
+    m_dirty.store(true, std::memory_order_relaxed);
+}
+
+void StatsTracker::flush() {
+    if (!m_dirty.exchange(false)) return;
+
+    QMutexLocker lock(&m_settingsMutex);
+    for (int c = 0; c < CounterCount; ++c) settings.setValue(Keys[c], m_counts[c].load(std::memory_order_relaxed));
+    settings.sync();
+}
+
 void StatsTracker::trackDeckCreated() {
-    int current = settings.value("decksCreated", 0).toInt();
-    settings.setValue("decksCreated", current + 1);
+    track(DecksCreated);
 }
 
 void StatsTracker::trackCardCreated() {
-    int current = settings.value("cardsCreated", 0).toInt();
-    settings.setValue("cardsCreated", current + 1);
+    track(CardsCreated);
 }
 
 void StatsTracker::trackReview() {
-    int current = settings.value("cardsReviewed", 0).toInt();
-    settings.setValue("cardsReviewed", current + 1);
+    track(CardsReviewed);
 }
 
 int StatsTracker::getTotalDecks() const {
-    return settings.value("decksCreated", 0).toInt();
+    return m_counts[DecksCreated].load(std::memory_order_relaxed);
 }
 
 int StatsTracker::getTotalCards() const {
-    return settings.value("cardsCreated", 0).toInt();
+    return m_counts[CardsCreated].load(std::memory_order_relaxed);
 }
 
 int StatsTracker::getTotalReviews() const {
-    return settings.value("cardsReviewed", 0).toInt();
+    return m_counts[CardsReviewed].load(std::memory_order_relaxed);
 }
 
 void StatsTracker::resetStats() {
+    QMutexLocker lock(&m_settingsMutex);
+    for (int c = 0; c < CounterCount; ++c) m_counts[c] = 0;
+    m_dirty = false;
     settings.clear();
 }
 void StatsTracker::trackCorrectAnswer() {
-    int current = settings.value("answersCorrect", 0).toInt();
-    settings.setValue("answersCorrect", current + 1);
+    track(AnswersCorrect);
 }
 
 void StatsTracker::trackIncorrectAnswer() {
-    int current = settings.value("answersIncorrect", 0).toInt();
-    settings.setValue("answersIncorrect", current + 1);
+    track(AnswersIncorrect);
 }
 int StatsTracker::getTotalCorrect() const {
-    return settings.value("answersCorrect", 0).toInt();
+    return m_counts[AnswersCorrect].load(std::memory_order_relaxed);
 }
 
 int StatsTracker::getTotalIncorrect() const {
-    return settings.value("answersIncorrect", 0).toInt();
+    return m_counts[AnswersIncorrect].load(std::memory_order_relaxed);
 }
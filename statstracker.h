@@ -1,8 +1,19 @@
 #ifndef STATSTRACKER_H
 #define STATSTRACKER_H
 
+#include <QMutex>
 #include <QSettings>
 #include <QString>
+#include <atomic>
+
+/*
+ * StatsTracker (Singleton) - lifetime study counters
+ *
+ *  - Counters live in memory as atomics, so track*() is one relaxed increment
+ *    and safe from any thread.
+ *  - They are written to QSettings every few seconds by a timer on the
+ *    application thread, when the application quits and on flush().
+ */
 
 class StatsTracker
 {
@@ -22,9 +33,19 @@ public:
     int getTotalIncorrect() const;
     void resetStats();
 
+    void flush();   // writes the counters to settings if any changed
+
 private:
+    enum Counter { DecksCreated, CardsCreated, CardsReviewed, AnswersCorrect, AnswersIncorrect, CounterCount };
+
     StatsTracker();
+    ~StatsTracker();
+    void track(Counter c);
+
+    QMutex m_settingsMutex;   // QSettings isn't safe to share between threads
     QSettings settings;
+    std::atomic<int> m_counts[CounterCount];
+    std::atomic<bool> m_dirty{false};
 
 };
 
@@ -0,0 +1,131 @@
+#include "statswindow.h"
+#include "flashcardmanager.h"
+#include "statstracker.h"
+
+#include <QDateTime>
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTabWidget>
+#include <QTableWidget>
+#include <QVBoxLayout>
+#include <algorithm>
+
+static const QStringList Columns = { "Name", "Reviews", "Accuracy", "Streak", "Best Streak",
+                                     "Median Time", "90th pct. Time", "Last Review" };
+
+static QString formatMs(quint32 ms)
+{
+    return ms < 10000 ? QString("%1 ms").arg(ms) : QString("%1 s").arg(ms / 1000.0, 0, 'f', 1);
+}
+
+// Displays formatted text but sorts by the number behind it
+class NumberItem : public QTableWidgetItem
+{
+public:
+    NumberItem(double value, const QString &text) : QTableWidgetItem(text), m_value(value)
+    {
+        setTextAlignment(Qt::AlignRight | Qt::AlignVCenter);
+    }
+
+    bool operator<(const QTableWidgetItem &other) const override
+    {
+        const auto *n = dynamic_cast<const NumberItem *>(&other);
+        return n ? m_value < n->m_value : QTableWidgetItem::operator<(other);
+    }
+
+private:
+    double m_value;
+};
+
+static QTableWidgetItem *numberItem(double value, const QString &text)
+{
+    return new NumberItem(value, text);
+}
+
+StatsWindow::StatsWindow(QWidget *parent)
+    : QDialog(parent)
+    , m_summary(new QLabel(this))
+    , m_decks(new QTableWidget(this))
+    , m_tags(new QTableWidget(this))
+{
+    setWindowTitle("Statistics");
+    resize(820, 520);
+
+    auto *tabs = new QTabWidget(this);
+    tabs->addTab(m_decks, "Decks");
+    tabs->addTab(m_tags, "Tags");
+
+    auto *buttons = new QDialogButtonBox(QDialogButtonBox::Close, this);
+    QPushButton *refreshButton = buttons->addButton("Refresh", QDialogButtonBox::ActionRole);
+    connect(refreshButton, &QPushButton::clicked, this, &StatsWindow::refresh);
+    connect(buttons, &QDialogButtonBox::rejected, this, &QDialog::close);
+
+    auto *layout = new QVBoxLayout(this);
+    layout->addWidget(m_summary);
+    layout->addWidget(tabs);
+    layout->addWidget(buttons);
+
+    for (QTableWidget *table : { m_decks, m_tags }) {
+        table->setColumnCount(Columns.size());
+        table->setHorizontalHeaderLabels(Columns);
+        table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        table->setSelectionBehavior(QAbstractItemView::SelectRows);
+        table->verticalHeader()->hide();
+        table->horizontalHeader()->setSectionResizeMode(0, QHeaderView::Stretch);
+    }
+
+    refresh();
+}
+
+void StatsWindow::refresh()
+{
+    QString err;
+    const ReviewStats stats = flashcardManager::instance().reviewStats(&err);
+    const ReviewAggregate &all = stats.library();
+    StatsTracker &tracker = StatsTracker::instance();
+
+    QString summary = QString("Decks created: %1    Cards created: %2    Answers: %3 correct, %4 incorrect\n"
+                              "Logged reviews: %5    Accuracy: %6%    Best streak: %7    Median time: %8")
+        .arg(tracker.getTotalDecks())
+        .arg(tracker.getTotalCards())
+        .arg(tracker.getTotalCorrect())
+        .arg(tracker.getTotalIncorrect())
+        .arg(all.reviews)
+        .arg(all.accuracy() * 100.0, 0, 'f', 1)
+        .arg(all.bestStreak)
+        .arg(formatMs(all.latency.percentile(50)));
+    if (!err.isEmpty()) summary += "\n" + err;
+    m_summary->setText(summary);
+
+    QStringList decks = stats.deckNames();
+    QStringList tags = stats.tagKeys();
+    std::sort(decks.begin(), decks.end());
+    std::sort(tags.begin(), tags.end());
+    fillTable(m_decks, decks, [&stats](const QString &name) { return stats.deck(name); });
+    fillTable(m_tags, tags, [&stats](const QString &name) { return stats.tag(name); });
+}
+
+void StatsWindow::fillTable(QTableWidget *table, const QStringList &names,
+                            const std::function<ReviewAggregate(const QString &)> &aggregate)
+{
+    table->setSortingEnabled(false);
+    table->setRowCount(names.size());
+    for (int row = 0; row < names.size(); ++row) {
+        const ReviewAggregate a = aggregate(names[row]);
+        const quint32 median = a.latency.percentile(50);
+        const quint32 p90 = a.latency.percentile(90);
+
+        table->setItem(row, 0, new QTableWidgetItem(names[row]));
+        table->setItem(row, 1, numberItem(a.reviews, QString::number(a.reviews)));
+        table->setItem(row, 2, numberItem(a.accuracy(), QString("%1%").arg(a.accuracy() * 100.0, 0, 'f', 1)));
+        table->setItem(row, 3, numberItem(a.streak, QString::number(a.streak)));
+        table->setItem(row, 4, numberItem(a.bestStreak, QString::number(a.bestStreak)));
+        table->setItem(row, 5, numberItem(median, formatMs(median)));
+        table->setItem(row, 6, numberItem(p90, formatMs(p90)));
+        table->setItem(row, 7, new QTableWidgetItem(
+            QDateTime::fromMSecsSinceEpoch(a.lastReview).toString("yyyy-MM-dd hh:mm")));
+    }
+    table->setSortingEnabled(true);
+}
@@ -0,0 +1,31 @@
+#ifndef STATSWINDOW_H
+#define STATSWINDOW_H
+
+#include <QDialog>
+#include <functional>
+#include "reviewstats.h"
+
+class QLabel;
+class QTableWidget;
+
+// Dashboard over flashcardManager::reviewStats(): library summary, then one row per deck and per tag
+class StatsWindow : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit StatsWindow(QWidget *parent = nullptr);
+
+private slots:
+    void refresh();
+
+private:
+    static void fillTable(QTableWidget *table, const QStringList &names,
+                          const std::function<ReviewAggregate(const QString &)> &aggregate);
+
+    QLabel *m_summary;
+    QTableWidget *m_decks;
+    QTableWidget *m_tags;
+};
+
+#endif // STATSWINDOW_H
@@ -0,0 +1,59 @@
+#include "stringpool.h"
+
+StringPool::StringPool(int maxLength)
+    : m_maxLength(maxLength)
+{
+}
+
+QString StringPool::intern(const QString &s)
+{
+    if (s.isEmpty() || s.size() > m_maxLength) return s;
+
+    ++m_lookups;
+    const auto it = m_strings.find(s);
+    if (it != m_strings.end()) {
+        ++m_hits;
+        if (it.key().constData() != s.constData()) {
+            ++it.value();
+            m_bytesSaved += qint64(s.size()) * qint64(sizeof(QChar));
+        }
+        return it.key();
+    }
+
+    m_strings.insert(s, 0);
+    m_poolBytes += qint64(s.size()) * qint64(sizeof(QChar));
+    return s;
+}
+
+// An entry whose buffer isn't shared is only kept alive by the pool
+void StringPool::prune()
+{
+    for (auto it = m_strings.begin(); it != m_strings.end();) {
+        if (it.key().isDetached()) {
+            const qint64 bytes = qint64(it.key().size()) * qint64(sizeof(QChar));
+            m_poolBytes -= bytes;
+            m_bytesSaved -= bytes * it.value();
+            it = m_strings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+void StringPool::clear()
+{
+    m_strings.clear();
+    m_poolBytes = 0;
+    m_bytesSaved = 0;
+}
+
+StringPool::Stats StringPool::stats() const
+{
+    Stats s;
+    s.lookups = m_lookups;
+    s.hits = m_hits;
+    s.bytesSaved = m_bytesSaved;
+    s.uniqueStrings = m_strings.size();
+    s.poolBytes = m_poolBytes;
+    return s;
+}
@@ -0,0 +1,51 @@
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <QHash>
+#include <QString>
+
+/*
+ * StringPool (interning for card and tag text)
+ *
+ *  - intern() returns the pooled QString equal to its argument, adding it if it is
+ *    new. Equal strings then share one implicitly shared buffer, so an answer like
+ *    "true" repeated across thousands of cards is stored once.
+ *  - Only strings up to maxLength characters are pooled; long questions are rarely
+ *    repeated and would just cost a hash.
+ *  - prune() drops entries nothing outside the pool references any more, together
+ *    with the savings counted for them, so stats() describes the live pool.
+ *  - Strings passed in must own their buffer (not QString::fromRawData): a new
+ *    string is pooled as given. Decks hand out owning text on both layouts.
+ *  - Not thread-safe; flashcardManager only uses it under its own mutex.
+ */
+
+class StringPool
+{
+public:
+    struct Stats
+    {
+        qint64 lookups = 0;        // since construction
+        qint64 hits = 0;           // lookups answered from the pool, since construction
+        qint64 bytesSaved = 0;     // duplicates folded into strings still in the pool
+        int uniqueStrings = 0;
+        qint64 poolBytes = 0;      // payload held by the pool's strings
+    };
+
+    explicit StringPool(int maxLength = 256);
+
+    QString intern(const QString &s);
+    void prune();
+    void clear();
+
+    Stats stats() const;
+
+private:
+    QHash<QString, int> m_strings;   // pooled string -> duplicates folded into it
+    int m_maxLength;
+    qint64 m_lookups = 0;
+    qint64 m_hits = 0;
+    qint64 m_bytesSaved = 0;
+    qint64 m_poolBytes = 0;
+};
+
+#endif // STRINGPOOL_H
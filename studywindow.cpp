@@ -1,30 +1,84 @@
 #include "studywindow.h"
 #include "ui_studywindow.h"
 #include "statstracker.h"
+#include "flashcardmanager.h"
+#include "instrumentation.h"
+#include <QDateTime>
 #include <QMessagebox>
 
-studywindow::studywindow(deck *deck, QWidget *parent)
+studywindow::studywindow(deck *deck, QWidget *parent, Mode mode)
     : QWidget(parent)
     , ui(new Ui::studywindow)
     , currentdeck(deck)
     , currentIndex(0)
+    , mode(mode)
 {
     ui->setupUi(this);
 
-    if(currentdeck)
-        setWindowTitle("Quiz: " + currentdeck->getName());
-    else
-        setWindowTitle("Quiz Mode");
-
     connect(ui->checkAnswerButton, &QPushButton::clicked, this, &studywindow::onCheckAnswerClicked);
     connect(ui->nextButton, &QPushButton::clicked, this, &studywindow::onNextCardClicked);
     connect(ui->returnButton, &QPushButton::clicked, this, &studywindow::onReturnClicked);
 
+    setMode(mode);
+}
+
+void studywindow::setMode(Mode newMode) {
+    mode = newMode;
+    const QString prefix = mode == Mode::Due ? "Due Cards" : "Quiz";
+    if(currentdeck)
+        setWindowTitle(prefix + ": " + currentdeck->getName());
+    else
+        setWindowTitle(mode == Mode::Due ? prefix : "Quiz Mode");
+
+    dueCard = DueCard();
+    reloadCardIds();
     updateCardDisplay();
 }
 
+void studywindow::reloadCardIds() {
+    cardIds = currentdeck ? currentdeck->cardIds() : QVector<quint64>();
+    currentIndex = 0;
+}
+
+// Card at currentIndex, skipping any removed since the pass started
+const flashcard *studywindow::currentCard() {
+    if (mode == Mode::Due) {
+        if (dueCard.cardId == 0) return nullptr;
+        const deck *d = currentdeck ? currentdeck : flashcardManager::instance().getDeck(dueCard.deckName);
+        return d ? d->findCard(dueCard.cardId) : nullptr;
+    }
+    if (!currentdeck) return nullptr;
+    while (currentIndex < cardIds.size()) {
+        if (const flashcard *card = currentdeck->findCard(cardIds[currentIndex])) return card;
+        ++currentIndex;
+    }
+    return nullptr;
+}
+
 void studywindow::updateCardDisplay() {
-    if (!currentdeck || currentdeck->getSize() == 0) {
+    ScopedTimer timer("study.updateCardDisplay", "ui");
+    if (mode == Mode::Due && dueCard.cardId == 0) {
+        const DueCard next = flashcardManager::instance().nextDueCard(currentdeck ? currentdeck->getName() : QString());
+        if (next.cardId != 0 && next.due <= QDateTime::currentSecsSinceEpoch()) {
+            dueCard = next;
+        } else {
+            ui->questionLabel->setText(next.cardId == 0
+                ? QString("No cards to review.")
+                : "No cards due. Next review: " + QDateTime::fromSecsSinceEpoch(next.due).toString("yyyy-MM-dd hh:mm"));
+            ui->answerInput->setEnabled(false);
+            ui->checkAnswerButton->setEnabled(false);
+            ui->nextButton->setEnabled(false);
+            ui->feedbackLabel->clear();
+            return;
+        }
+    }
+
+    const flashcard *card = currentCard();
+    if (!card && mode == Mode::Sequential && currentdeck && currentdeck->getSize() > 0) {
+        reloadCardIds();
+        card = currentCard();
+    }
+    if (!card) {
         ui->questionLabel->setText("No cards in this deck.");
         ui->answerInput->setEnabled(false);
         ui->checkAnswerButton->setEnabled(false);
@@ -33,38 +87,64 @@ void studywindow::updateCardDisplay() {
         return;
     }
 
-    flashcard card = currentdeck->getCard(currentIndex);
-    ui->questionLabel->setText(card.getQuestion());
+    ui->questionLabel->setText(card->getQuestion());
     ui->answerInput->clear();
     ui->feedbackLabel->clear();
     ui->answerInput->setEnabled(true);
     ui->checkAnswerButton->setEnabled(true);
+    shownFor.start();
+    shownAtNs = Instrumentation::instance().now();
+    // A due card has to be graded before moving on, or it would just come back
+    ui->nextButton->setEnabled(mode == Mode::Sequential);
 }
 
 void studywindow::onCheckAnswerClicked() {
-    if (!currentdeck) return;
+    ScopedTimer timer("study.checkAnswer", "ui");
+    const flashcard *card = currentCard();
+    if (!card) return;
+
+    // The user's thinking time, as its own span on the trace
+    if (shownAtNs >= 0) {
+        Instrumentation &in = Instrumentation::instance();
+        in.record("study.answer", "user", shownAtNs, in.now() - shownAtNs);
+        shownAtNs = -1;
+    }
 
-    flashcard card = currentdeck->getCard(currentIndex);
     QString userAnswer = ui->answerInput->text().trimmed();
 
-    if (userAnswer.compare(card.getAnswer().trimmed(), Qt::CaseInsensitive) == 0) {
+    const bool correct = userAnswer.compare(card->getAnswer().trimmed(), Qt::CaseInsensitive) == 0;
+    if (correct) {
         ui->feedbackLabel->setText("✅ Correct!");
         StatsTracker::instance().trackCorrectAnswer();
     } else {
-        ui->feedbackLabel->setText("❌ Incorrect. The answer is: " + card.getAnswer());
+        ui->feedbackLabel->setText("❌ Incorrect. The answer is: " + card->getAnswer());
         StatsTracker::instance().trackIncorrectAnswer();
     }
     StatsTracker::instance().trackReview();
     ui->checkAnswerButton->setEnabled(false);
+
+    const int grade = correct ? ReviewScheduler::Good : ReviewScheduler::Again;
+    const QString deckName = mode == Mode::Due ? dueCard.deckName : currentdeck->getName();
+    flashcardManager::instance().logReview(deckName, card->getId(), grade,
+                                           quint32(qMin<qint64>(shownFor.elapsed(), 0xFFFFFFFF)));
+    if (mode == Mode::Due) {
+        flashcardManager::instance().reviewCard(dueCard.deckName, dueCard.cardId, grade);
+        ui->nextButton->setEnabled(true);
+    }
 }
 
 void studywindow::onNextCardClicked() {
+    if (mode == Mode::Due) {
+        dueCard = DueCard();
+        updateCardDisplay();
+        return;
+    }
     if (!currentdeck) return;
 
     currentIndex++;
-    if (currentIndex >= currentdeck->getSize()) {
+    if (!currentCard()) {
         QMessageBox::information(this, "End of Deck", "You’ve finished all questions!");
-        currentIndex = 0;
+        reloadCardIds();
     }
     updateCardDisplay();
 }
@@ -1,8 +1,10 @@
 #ifndef STUDYWINDOW_H
 #define STUDYWINDOW_H
 
+#include <QElapsedTimer>
 #include <QWidget>
 #include "deck.h"
+#include "reviewscheduler.h"
 
 namespace Ui {
 class studywindow;
@@ -13,9 +15,15 @@ class studywindow : public QWidget
     Q_OBJECT
 
 public:
-    explicit studywindow(deck *deck, QWidget *parent = nullptr);
+    // Sequential steps through the deck in order. Due asks the scheduler for the next due
+    // card of the deck (of the whole library if deck is null) and grades each answer.
+    enum class Mode { Sequential, Due };
+
+    explicit studywindow(deck *deck, QWidget *parent = nullptr, Mode mode = Mode::Sequential);
     ~studywindow();
 
+    void setMode(Mode mode);
+
 private slots:
     void onCheckAnswerClicked();
     void onNextCardClicked();
@@ -23,9 +31,17 @@ private slots:
     void onReturnClicked();
 
 private:
+    void reloadCardIds();
+    const flashcard *currentCard();
+
     Ui::studywindow *ui;
     deck *currentdeck;
     int currentIndex;
+    QVector<quint64> cardIds;   // study order, taken when a pass starts
+    Mode mode;
+    DueCard dueCard;            // Due mode: card on screen, cardId 0 = fetch the next one
+    QElapsedTimer shownFor;     // since the current card was shown, for the review log
+    qint64 shownAtNs = -1;      // same moment on the instrumentation clock
 };
 
 #endif // STUDYWINDOW_H
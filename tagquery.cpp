@@ -0,0 +1,213 @@
+#include "tagquery.h"
+
+#include <QStringList>
+
+namespace {
+struct Token
+{
+    enum Kind { Word, And, Or, Not, Open, Close, End } kind;
+    QString text;
+};
+
+QVector<Token> tokenize(const QString &text, QString *errorOut, bool *ok)
+{
+    QVector<Token> tokens;
+    *ok = true;
+    int i = 0;
+    while (i < text.size()) {
+        const QChar c = text.at(i);
+        if (c.isSpace()) {
+            ++i;
+        } else if (c == '(' || c == ')') {
+            tokens.append(Token{ c == '(' ? Token::Open : Token::Close, QString() });
+            ++i;
+        } else if (c == '"') {
+            const int close = text.indexOf('"', i + 1);
+            if (close < 0) {
+                if (errorOut) *errorOut = "Unterminated quote in tag filter.";
+                *ok = false;
+                return tokens;
+            }
+            tokens.append(Token{ Token::Word, text.mid(i + 1, close - i - 1) });
+            i = close + 1;
+        } else {
+            int end = i;
+            while (end < text.size() && !text.at(end).isSpace() && text.at(end) != '(' && text.at(end) != ')'
+                   && text.at(end) != '"') {
+                ++end;
+            }
+            const QString word = text.mid(i, end - i);
+            if (word == "AND") tokens.append(Token{ Token::And, QString() });
+            else if (word == "OR") tokens.append(Token{ Token::Or, QString() });
+            else if (word == "NOT") tokens.append(Token{ Token::Not, QString() });
+            else tokens.append(Token{ Token::Word, word });
+            i = end;
+        }
+    }
+    tokens.append(Token{ Token::End, QString() });
+    return tokens;
+}
+
+// Smaller side is walked, larger side probed
+QSet<QString> intersect(const QSet<QString> &a, const QSet<QString> &b)
+{
+    const QSet<QString> &small = a.size() <= b.size() ? a : b;
+    const QSet<QString> &large = a.size() <= b.size() ? b : a;
+    QSet<QString> out;
+    for (const QString &s : small) {
+        if (large.contains(s)) out.insert(s);
+    }
+    return out;
+}
+
+QSet<QString> subtract(const QSet<QString> &a, const QSet<QString> &b)
+{
+    QSet<QString> out;
+    for (const QString &s : a) {
+        if (!b.contains(s)) out.insert(s);
+    }
+    return out;
+}
+}
+
+class TagQueryParser
+{
+public:
+    TagQueryParser(TagQuery &q, const QVector<Token> &tokens) : m_q(q), m_tokens(tokens) {}
+
+    int parseOr()
+    {
+        int left = parseAnd();
+        while (left >= 0 && peek() == Token::Or) {
+            ++m_pos;
+            const int right = parseAnd();
+            if (right < 0) return -1;
+            left = add(TagQuery::Node::Or, QString(), left, right);
+        }
+        return left;
+    }
+
+    bool atEnd() const { return peek() == Token::End; }
+    QString error;
+
+private:
+    Token::Kind peek() const { return m_tokens.at(m_pos).kind; }
+
+    int add(TagQuery::Node::Kind kind, const QString &tag, int left, int right)
+    {
+        TagQuery::Node n;
+        n.kind = kind;
+        n.tag = tag;
+        n.left = left;
+        n.right = right;
+        m_q.m_nodes.append(n);
+        return m_q.m_nodes.size() - 1;
+    }
+
+    int parseAnd()
+    {
+        int left = parseUnary();
+        while (left >= 0 && peek() == Token::And) {
+            ++m_pos;
+            const int right = parseUnary();
+            if (right < 0) return -1;
+            left = add(TagQuery::Node::And, QString(), left, right);
+        }
+        return left;
+    }
+
+    int parseUnary()
+    {
+        switch (peek()) {
+        case Token::Not: {
+            ++m_pos;
+            const int operand = parseUnary();
+            return operand < 0 ? -1 : add(TagQuery::Node::Not, QString(), operand, -1);
+        }
+        case Token::Open: {
+            ++m_pos;
+            const int inner = parseOr();
+            if (inner < 0) return -1;
+            if (peek() != Token::Close) {
+                error = "Missing ')' in tag filter.";
+                return -1;
+            }
+            ++m_pos;
+            return inner;
+        }
+        case Token::Word: {
+            QStringList words;
+            while (peek() == Token::Word) words.append(m_tokens.at(m_pos++).text);
+            return add(TagQuery::Node::Tag, TagQuery::key(words.join(' ')), -1, -1);
+        }
+        default:
+            error = "Expected a tag in tag filter.";
+            return -1;
+        }
+    }
+
+    TagQuery &m_q;
+    const QVector<Token> &m_tokens;
+    int m_pos = 0;
+};
+
+TagQuery TagQuery::parse(const QString &text, QString *errorOut)
+{
+    TagQuery q;
+    bool ok = false;
+    const QVector<Token> tokens = tokenize(text, errorOut, &ok);
+    if (!ok) return q;
+
+    TagQueryParser parser(q, tokens);
+    const int root = parser.parseOr();
+    if (root >= 0 && !parser.atEnd()) parser.error = "Expected AND, OR or ')' in tag filter.";
+    if (root < 0 || !parser.error.isEmpty()) {
+        if (errorOut) *errorOut = parser.error;
+        q.m_nodes.clear();
+        return q;
+    }
+    q.m_root = root;
+    return q;
+}
+
+QString TagQuery::key(const QString &tag)
+{
+    return tag.simplified().toLower();
+}
+
+TagQuery::Result TagQuery::eval(int node, const Postings &postings) const
+{
+    const Node &n = m_nodes.at(node);
+    Result r;
+    if (n.kind == Node::Tag) {
+        if (const QSet<QString> *decks = postings(n.tag)) r.set = *decks;
+        return r;
+    }
+    if (n.kind == Node::Not) {
+        r = eval(n.left, postings);
+        r.complement = !r.complement;
+        return r;
+    }
+
+    const Result a = eval(n.left, postings);
+    const Result b = eval(n.right, postings);
+    if (n.kind == Node::And) {
+        if (!a.complement && !b.complement) r.set = intersect(a.set, b.set);
+        else if (!a.complement) r.set = subtract(a.set, b.set);
+        else if (!b.complement) r.set = subtract(b.set, a.set);
+        else r = { a.set | b.set, true };
+    } else {
+        if (!a.complement && !b.complement) r.set = a.set | b.set;
+        else if (!a.complement) r = { subtract(b.set, a.set), true };
+        else if (!b.complement) r = { subtract(a.set, b.set), true };
+        else r = { intersect(a.set, b.set), true };
+    }
+    return r;
+}
+
+QSet<QString> TagQuery::evaluate(const Postings &postings, const Universe &universe) const
+{
+    if (m_root < 0) return QSet<QString>();
+    const Result r = eval(m_root, postings);
+    return r.complement ? subtract(universe(), r.set) : r.set;
+}
@@ -0,0 +1,59 @@
+#ifndef TAGQUERY_H
+#define TAGQUERY_H
+
+#include <QSet>
+#include <QString>
+#include <QVector>
+#include <functional>
+
+/*
+ * TagQuery (boolean deck filters over the tag index)
+ *
+ * Syntax:  spanish AND NOT verbs      (AND binds tighter than OR)
+ *          (french OR german) AND a1
+ *          world history               (words between operators form one tag)
+ *          "rock AND roll"             (quotes make a keyword part of a tag)
+ *
+ *  - Operators are the upper-case words AND, OR, NOT plus parentheses.
+ *  - Tags compare case-insensitively; key() gives the form the index stores.
+ *  - Evaluation only touches the posting sets of the tags named. A NOT is kept
+ *    as a complement until it meets a positive set, so "a AND NOT b" costs
+ *    |a| + |b|; only a query that is negative as a whole needs every deck name.
+ */
+
+class TagQuery
+{
+public:
+    using Postings = std::function<const QSet<QString> *(const QString &key)>;   // nullptr = no decks
+    using Universe = std::function<QSet<QString>()>;
+
+    static TagQuery parse(const QString &text, QString *errorOut = nullptr);
+    static QString key(const QString &tag);
+
+    bool isValid() const { return m_root >= 0; }
+    QSet<QString> evaluate(const Postings &postings, const Universe &universe) const;
+
+private:
+    struct Node
+    {
+        enum Kind { Tag, And, Or, Not } kind;
+        QString tag;     // Tag: normalized key
+        int left = -1;
+        int right = -1;
+    };
+
+    struct Result
+    {
+        QSet<QString> set;
+        bool complement = false;   // matches everything except set
+    };
+
+    Result eval(int node, const Postings &postings) const;
+
+    QVector<Node> m_nodes;
+    int m_root = -1;
+
+    friend class TagQueryParser;
+};
+
+#endif // TAGQUERY_H